@@ -3,8 +3,31 @@
 #include "include/mesh_object.hpp"
 #include "include/empty_object.hpp"
 #include "include/camera.hpp"
-
+#include "include/frame_scheduler.hpp"
+#include "include/profiler.hpp"
+#include "include/mesh_import.hpp"
+#include "include/render_target.hpp"
+#include "include/frame_capture.hpp"
+#include "include/soft_rasterizer.hpp"
+#include "include/scene_graph.hpp"
+#include "include/procedural_shape.hpp"
+#include "include/multi_view.hpp"
+#include "include/dynamic_resolution.hpp"
+#include "include/post_process.hpp"
+#include "include/debug_draw.hpp"
+#include "include/frustum.hpp"
+#include "include/frame_packet.hpp"
+#include "include/render_thread.hpp"
+#include "include/mesh_loader.hpp"
+
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <filesystem>
 #include <iostream>
+#include <memory>
 #include <vector>
 
 static int WIN_WIDTH  = 800;
@@ -19,35 +42,71 @@ struct Mouse {
 
 Camera viewCam(glm::vec3(0.0f, 0.0f, -6.0f));
 
+// world units per second
+constexpr GLfloat CAMERA_SPEED = 3.0f;
+
+// degrees per second the camera turns around the target with --orbit
+constexpr GLfloat ORBIT_SPEED = 30.0f;
+
+// silhouette error the tube meshes are sampled for, in pixels at the starting camera distance
+constexpr GLfloat TUBE_ERROR_PIXELS = 0.5f;
+
+// half the height of the world the top, front and side views of --quad-view show
+constexpr GLfloat QUAD_VIEW_EXTENT = 2.5f;
+
+// simulated time per frame in headless mode, so recorded sequences do not depend on render speed
+constexpr GLdouble HEADLESS_STEP = 1.0 / 60.0;
+
+GLboolean orbit = GL_FALSE;
+
+// set by the F1, F2, F11 and F12 keys, passed on in the next frame packet to the thread that owns the gl context
+GLboolean screenshotRequested = GL_FALSE;
+GLboolean recordingToggled	  = GL_FALSE;
+GLboolean overlayToggled	  = GL_FALSE;
+GLboolean traceRequested	  = GL_FALSE;
+
+GLboolean keys[GLFW_KEY_LAST + 1];
+
+std::vector <glm::vec3> lightPos {
+	glm::vec3(0.0f, 30.0f, 30.0f),
+	glm::vec3(30.0f, -30.0f, 0.0f),
+	glm::vec3(-30.0f, 0.0f, -30.0f)
+};
+
+FrameScheduler scheduler(120.0, 0.0, GL_TRUE);
+
+// movement is applied in update() with the elapsed time, the callback only records key state
 void keyCallback(GLFWwindow* window, int key, int scancode, int action, int mods) {
-	switch (key) {
-	case GLFW_KEY_W:
-		if (action == GLFW_REPEAT || action == GLFW_PRESS) {
-			viewCam.TranslateLocal(0.1f, cameraDirection::front);
-		}
-		break;
+	if (key < 0 || key > GLFW_KEY_LAST) { return; }
 
-	case GLFW_KEY_S:
-		if (action == GLFW_REPEAT || action == GLFW_PRESS) {
-			viewCam.TranslateLocal(-0.1f, cameraDirection::front);
-		}
-		break;
+	// F1 toggles the profiler overlay, F2 writes the recorded frames as a chrome trace
+	if (action == GLFW_PRESS && key == GLFW_KEY_F1) overlayToggled = GL_TRUE;
+	if (action == GLFW_PRESS && key == GLFW_KEY_F2) traceRequested = GL_TRUE;
 
-	case GLFW_KEY_D:
-		if (action == GLFW_REPEAT || action == GLFW_PRESS) {
-			viewCam.TranslateLocal(0.1f, cameraDirection::right);
-		}
-		break;
+	// F11 starts and stops recording every frame to ./capture, F12 saves a screenshot
+	if (action == GLFW_PRESS && key == GLFW_KEY_F11) recordingToggled = GL_TRUE;
+	if (action == GLFW_PRESS && key == GLFW_KEY_F12) screenshotRequested = GL_TRUE;
 
-	case GLFW_KEY_A:
-		if (action == GLFW_REPEAT || action == GLFW_PRESS) {
-			viewCam.TranslateLocal(-0.1f, cameraDirection::right);
-		}
-		break;
+	if (action == GLFW_PRESS)
+		keys[key] = GL_TRUE;
+	else if (action == GLFW_RELEASE)
+		keys[key] = GL_FALSE;
 
-	default:
-		break;
-	}
+	// keep the loop awake while the camera is moving
+	scheduler.SetAnimating(orbit || keys[GLFW_KEY_W] || keys[GLFW_KEY_S] || keys[GLFW_KEY_D] || keys[GLFW_KEY_A]);
+	scheduler.RequestRedraw();
+}
+
+// fixed timestep update, dt is in seconds
+void update(GLdouble dt) {
+	GLfloat step = CAMERA_SPEED * (GLfloat)dt;
+
+	if (keys[GLFW_KEY_W]) viewCam.TranslateLocal(step, cameraDirection::front);
+	if (keys[GLFW_KEY_S]) viewCam.TranslateLocal(-step, cameraDirection::front);
+	if (keys[GLFW_KEY_D]) viewCam.TranslateLocal(step, cameraDirection::right);
+	if (keys[GLFW_KEY_A]) viewCam.TranslateLocal(-step, cameraDirection::right);
+
+	if (orbit) viewCam.Rotate(ORBIT_SPEED * (GLfloat)dt, glm::vec3(0.0f, 0.0f, 1.0f));
 }
 
 void mouseButtonCallback(GLFWwindow* window, int button, int action, int mods) {
@@ -62,10 +121,14 @@ void mouseButtonCallback(GLFWwindow* window, int button, int action, int mods) {
 		// do nothing
 		break;
 	}
+
+	scheduler.RequestRedraw();
 }
 
 void scrollCallback(GLFWwindow* window, double offsetX, double offsetY) {
 	viewCam.Scale(offsetY * 0.125f + 1.0f);
+
+	scheduler.RequestRedraw();
 }
 
 void cursorPositionCallback(GLFWwindow* window, double posX, double posY) {
@@ -78,6 +141,8 @@ void cursorPositionCallback(GLFWwindow* window, double posX, double posY) {
 	if (mouse.middleButton) {
 		viewCam.Rotate(offsetX * 0.25f, glm::vec3(0.0f, 0.0f, 1.0f));
 		viewCam.RotateLocalX(offsetY * 0.25f);
+
+		scheduler.RequestRedraw();
 	}
 }
 
@@ -90,18 +155,343 @@ void windowSizeCallback(GLFWwindow* window, int width, int height) {
 	glm::mat4 projection = glm::perspective(45.0f, (GLfloat)WIN_WIDTH / (GLfloat)WIN_HEIGHT, 0.01f, 1000.0f);
 	viewCam.projection_mat = projection;
 
-	glViewport(0, 0, WIN_WIDTH, WIN_HEIGHT);
+	// the viewport is set by the renderer from the size in the next frame packet
+	scheduler.RequestRedraw();
+}
+
+void windowRefreshCallback(GLFWwindow* window) {
+	scheduler.RequestRedraw();
+}
+
+// parses an obj with the streaming importer and with the ifstream baseline, no window is opened
+int importBenchmark(const char* path) {
+	MappedFile file;
+	if (!file.Open(path)) {
+		std::cout << "Failed to open " << path << std::endl;
+		return -1;
+	}
+
+	GLdouble megabytes = file.Size() / (1024.0 * 1024.0);
+
+	std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+	MeshData streamed;
+	bool streamLoaded = MeshImporter::LoadOBJ(file, streamed);
+	GLdouble streamSeconds = std::chrono::duration<GLdouble>(std::chrono::steady_clock::now() - start).count();
+
+	start = std::chrono::steady_clock::now();
+	MeshData naive;
+	bool naiveLoaded = MeshImporter::LoadOBJNaive(path, naive);
+	GLdouble naiveSeconds = std::chrono::duration<GLdouble>(std::chrono::steady_clock::now() - start).count();
+
+	if (!streamLoaded || !naiveLoaded) {
+		std::cout << "Failed to parse " << path << std::endl;
+		return -1;
+	}
+
+	std::cout << path << ": " << megabytes << " MB, " << streamed.indices.size() / 3 << " triangles, " << streamed.vertices.size() / 6 << " vertices\n";
+	std::cout << "  streaming: " << streamSeconds * 1000.0 << " ms, " << megabytes / streamSeconds << " MB/s\n";
+	std::cout << "  ifstream:  " << naiveSeconds * 1000.0 << " ms, " << megabytes / naiveSeconds << " MB/s" << std::endl;
+
+	return 0;
+}
+
+// animates a forest of nodes and times SceneGraph::Update, no window is opened
+int sceneBenchmark(GLuint nodeCount) {
+	const GLuint TREE_SIZE = 100;
+	const GLuint FRAMES	   = 100;
+
+	SceneGraph scene;
+	scene.Reserve(nodeCount);
+
+	// trees of 100 nodes, every node below the one at half its index within the tree, 7 levels deep
+	for (GLuint i = 0; i < nodeCount; i++) {
+		GLuint local = i % TREE_SIZE;
+		SceneNode parent = (local == 0) ? NO_SCENE_NODE : i - local + (local - 1) / 2;
+
+		scene.Create(parent, glm::vec3(1.0f, 0.0f, 0.0f));
+	}
+
+	scene.Update();
+
+	// only the update is timed, stride picks which nodes are animated every frame
+	auto run = [&](GLuint first, GLuint stride) {
+		GLdouble totalMs = 0.0;
+
+		for (GLuint frame = 0; frame < FRAMES; frame++) {
+			for (GLuint i = first; i < nodeCount; i += stride) scene.Rotate(i, glm::vec3(0.0f, 0.0f, 1.0f), 0.01f);
+
+			std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+			scene.Update();
+			totalMs += std::chrono::duration<GLdouble, std::milli>(std::chrono::steady_clock::now() - start).count();
+		}
+
+		return totalMs / FRAMES;
+	};
+
+	GLdouble allMs = run(0, 1);
+	GLuint allUpdated = scene.updatedCount;
+
+	GLdouble leafMs = run(TREE_SIZE - 1, TREE_SIZE);
+	GLuint leafUpdated = scene.updatedCount;
+
+	std::cout << "scene graph: " << nodeCount << " nodes in trees of " << TREE_SIZE << "\n";
+	std::cout << "  every node animated: " << allMs << " ms/update, " << allUpdated << " world matrices\n";
+	std::cout << "  one leaf per tree:   " << leafMs << " ms/update, " << leafUpdated << " world matrices" << std::endl;
+
+	return 0;
+}
+
+// ring and triangle counts of adaptively sampled tubes against the fewest evenly spaced rings with the same error
+int tubeBenchmark() {
+	const GLuint DIVISIONS_N = 32;
+
+	struct Knot {
+		const char* name;
+		ClosedCurve curve;
+		GLfloat		radius;
+	};
+
+	std::vector <Knot> knots {
+		{ "trefoil", Trefoil::Curve(glm::vec3(0.0f), 1.0f), 0.17f },
+		{ "(3, 7) torus knot", TorusKnot::Curve(glm::vec3(0.0f), 3, 7, 0.33f), 0.08f }
+	};
+
+	for (const Knot& knot : knots) {
+		std::cout << knot.name << ", " << DIVISIONS_N << " segments per ring, at " << WIN_HEIGHT << " px and distance " << glm::length(viewCam.position) << "\n";
+
+		for (GLfloat pixels : { 2.0f, 1.0f, 0.5f, 0.25f }) {
+			GLfloat tolerance = TubeMesh::ScreenTolerance(pixels, glm::length(viewCam.position), glm::radians(45.0f), (GLfloat)WIN_HEIGHT);
+
+			GLuint adaptive = (GLuint)TubeMesh::SampleAdaptive(knot.curve, knot.radius, tolerance).size();
+			GLuint uniform	= TubeMesh::UniformRingsFor(knot.curve, knot.radius, tolerance);
+
+			std::cout << "  " << pixels << " px: adaptive " << adaptive << " rings, " << 2 * adaptive * DIVISIONS_N << " triangles, ";
+			std::cout << "uniform " << uniform << " rings, " << 2 * uniform * DIVISIONS_N << " triangles\n";
+		}
+	}
+
+	std::cout << std::flush;
+	return 0;
+}
+
+// world space error for TUBE_ERROR_PIXELS, the scene is set up for the starting camera distance
+GLfloat tubeTolerance() {
+	return TubeMesh::ScreenTolerance(TUBE_ERROR_PIXELS, glm::length(viewCam.position), glm::radians(45.0f), (GLfloat)WIN_HEIGHT);
+}
+
+// meshes placed by scene graph nodes, their model matrices are refreshed after every update
+struct SceneMesh {
+	MeshObject* mesh;
+	SceneNode	node;
+};
+
+void updateScene(SceneGraph& scene, const std::vector <SceneMesh>& meshes) {
+	scene.Update();
+
+	for (const SceneMesh& entry : meshes) entry.mesh->model_mat = scene.World(entry.node);
+}
+
+// a scene node drawn with the finest of its levels of detail that has finished loading, levels go from coarse to fine
+struct LoadingSceneMesh {
+	std::vector <MeshHandle> levels;
+	SceneNode node;
+
+	MeshObject* Finest() const {
+		for (auto level = levels.rbegin(); level != levels.rend(); level++) {
+			if (MeshObject* mesh = level->Get()) return mesh;
+		}
+
+		return nullptr;
+	}
+};
+
+// top, front and side views in the upper left, upper right and lower left quarter, the orbit camera in the lower right
+// every quarter has the aspect of the window, so the orbit camera keeps its projection
+void setQuadViews(MultiView& views, Camera* axisCams, const Camera& camera, GLint width, GLint height) {
+	GLfloat aspect = (GLfloat)width / (GLfloat)height;
+	glm::mat4 ortho = glm::ortho(-QUAD_VIEW_EXTENT * aspect, QUAD_VIEW_EXTENT * aspect, -QUAD_VIEW_EXTENT, QUAD_VIEW_EXTENT, 0.01f, 1000.0f);
+
+	for (GLuint i = 0; i < 3; i++) axisCams[i].projection_mat = ortho;
+
+	views.SetView(0, axisCams[0], glm::vec4(-1.0f, 0.0f, 0.0f, 1.0f));
+	views.SetView(1, axisCams[1], glm::vec4(0.0f, 0.0f, 1.0f, 1.0f));
+	views.SetView(2, axisCams[2], glm::vec4(-1.0f, -1.0f, 0.0f, 0.0f));
+	views.SetView(3, camera, glm::vec4(0.0f, -1.0f, 1.0f, 0.0f));
 }
 
-int main() {
-	
+// projection and starting orientation, shared by the gl and the software renderer
+void setupCamera() {
+	glm::mat4 projection = glm::perspective(glm::radians(45.0f), (GLfloat)WIN_WIDTH / (GLfloat)WIN_HEIGHT, 0.01f, 1000.0f);
+	viewCam.projection_mat = projection;
+
+	viewCam.Rotate(-45.0f, glm::vec3(1.0f, 0.0f, 0.0f));
+	viewCam.Rotate(-45.0f, glm::vec3(0.0f, 0.0f, 1.0f));
+}
+
+// draws the lit meshes with the cpu rasterizer for a number of frames, no window or gl context is created
+// grid and axis lines are left out, they are not part of the lit scene
+int softwareRender(GLuint frames, const std::string& screenshotPath, const char* modelPath) {
+	MeshObject::cpuOnly = GL_TRUE;
+	setupCamera();
+
+	UVSphere sphere1(0.75f, glm::vec3(-2.0f, 0.0f, 0.0f), 128, 64);
+	Torus torus(glm::vec3(2.0f, 0.0f, 0.0f), 0.20f, 0.5f, 32, 96);
+	Trefoil trefoil(glm::vec3(0.0f, 0.0f, 0.0f), tubeTolerance(), 32, 0.17f);
+
+	std::unique_ptr <ImportedMesh> model;
+	if (modelPath != nullptr) {
+		model.reset(new ImportedMesh(modelPath, glm::vec3(0.0f, 0.0f, 1.5f)));
+		if (!model->loaded) model.reset();
+	}
+
+	// every lit mesh hangs below one root node, moving the root moves the group
+	SceneGraph scene;
+	SceneNode shapesNode = scene.Create();
+
+	std::vector <SceneMesh> sceneMeshes { { &trefoil, scene.Create(shapesNode) }, { &sphere1, scene.Create(shapesNode) }, { &torus, scene.Create(shapesNode) } };
+	if (model) sceneMeshes.push_back({ model.get(), scene.Create(shapesNode) });
+
+	SoftRasterizer rasterizer(WIN_WIDTH, WIN_HEIGHT);
+	rasterizer.SetClearColor(glm::vec3(0.08f, 0.08f, 0.08f));
+	rasterizer.SetLights(lightPos);
+
+	GLdouble totalMs = 0.0, vertexMs = 0.0, binMs = 0.0, rasterMs = 0.0;
+	GLuint64 triangles = 0, shaded = 0;
+
+	for (GLuint frame = 0; frame < frames; frame++) {
+		update(HEADLESS_STEP);
+		updateScene(scene, sceneMeshes);
+
+		rasterizer.Draw(trefoil, viewCam);
+		rasterizer.Draw(sphere1, viewCam);
+		rasterizer.Draw(torus, viewCam);
+		if (model) rasterizer.Draw(*model, viewCam);
+
+		rasterizer.Render();
+
+		totalMs	 += rasterizer.stats.totalMs;
+		vertexMs += rasterizer.stats.vertexMs;
+		binMs	 += rasterizer.stats.binMs;
+		rasterMs += rasterizer.stats.rasterMs;
+
+		triangles += rasterizer.stats.trianglesSubmitted;
+		shaded	  += rasterizer.stats.pixelsShaded;
+	}
+
+	if (frames == 0 || totalMs <= 0.0) { return 0; }
+
+	GLdouble seconds = totalMs / 1000.0;
+	GLdouble pixels	 = (GLdouble)rasterizer.width * rasterizer.height * frames;
+
+	std::cout << "software: " << rasterizer.width << "x" << rasterizer.height << ", " << frames << " frames on " << rasterizer.ThreadCount() << " threads\n";
+	std::cout << "  " << totalMs / frames << " ms/frame (vertex " << vertexMs / frames << ", bin " << binMs / frames << ", raster and shade " << rasterMs / frames << ")\n";
+	std::cout << "  " << triangles / seconds / 1e6 << " Mtris/s, " << pixels / seconds / 1e6 << " Mpix/s, " << shaded / frames << " pixels shaded per frame" << std::endl;
+
+	if (!screenshotPath.empty() && !ImageWriter::WritePNG(screenshotPath, rasterizer.width, rasterizer.height, rasterizer.RGB().data())) {
+		std::cout << "ERROR::SOFT_RASTERIZER::CANNOT_WRITE_IMAGE\n";
+		std::cout << screenshotPath << std::endl;
+	}
+
+	return 0;
+}
+
+// first screenshot_NNNN.png that does not exist yet
+std::string nextScreenshotPath() {
+	char name[32];
+
+	for (GLuint i = 0; ; i++) {
+		std::snprintf(name, sizeof(name), "screenshot_%04u.png", i);
+		if (!std::filesystem::exists(name)) return name;
+	}
+}
+
+int main(int argc, char** argv) {
+	// time to first frame is measured from here
+	std::chrono::steady_clock::time_point launchTime = std::chrono::steady_clock::now();
+
+	const char* modelPath = nullptr;
+
+	// headless runs render a fixed number of frames into an invisible window and exit
+	GLboolean	headless		= GL_FALSE;
+	GLuint		headlessFrames	= 1;
+	std::string screenshotPath;
+	std::string recordDirectory;
+	std::string recordFormat	= "png";
+
+	GLboolean softRaster = GL_FALSE;
+	GLboolean procedural = GL_FALSE;
+	GLboolean quadView	 = GL_FALSE;
+
+	// --fxaa and --dynamic-res replace msaa with the post process pass, a target of 0 ms leaves the resolution fixed
+	GLboolean fxaa			  = GL_FALSE;
+	GLdouble  dynamicTargetMs = 0.0;
+
+	GLboolean showBounds = GL_FALSE;
+
+	// draw on a second thread that owns the gl context while the main thread updates the next frame
+	GLboolean renderThreaded = GL_FALSE;
+
+	// build the meshes on worker threads and upload them through a second context instead of before the first frame
+	GLboolean asyncMeshes = GL_FALSE;
+
+	for (int i = 1; i < argc; i++) {
+		// regenerate every mesh, used to measure cold startup
+		if (std::strcmp(argv[i], "--no-mesh-cache") == 0) MeshCache::enabled = GL_FALSE;
+
+		// an .obj, binary .ply or .glb file drawn next to the built in shapes
+		if (std::strcmp(argv[i], "--model") == 0 && i + 1 < argc) modelPath = argv[++i];
+
+		if (std::strcmp(argv[i], "--import-bench") == 0 && i + 1 < argc) return importBenchmark(argv[i + 1]);
+		if (std::strcmp(argv[i], "--tube-bench") == 0) return tubeBenchmark();
+		if (std::strcmp(argv[i], "--scene-bench") == 0) return sceneBenchmark((i + 1 < argc && std::atoi(argv[i + 1]) > 0) ? (GLuint)std::atoi(argv[i + 1]) : 100000);
+
+		if (std::strcmp(argv[i], "--headless") == 0) headless = GL_TRUE;
+		if (std::strcmp(argv[i], "--frames") == 0 && i + 1 < argc) headlessFrames = (GLuint)std::atoi(argv[++i]);
+		if (std::strcmp(argv[i], "--screenshot") == 0 && i + 1 < argc) screenshotPath = argv[++i];
+		if (std::strcmp(argv[i], "--record") == 0 && i + 1 < argc) recordDirectory = argv[++i];
+		if (std::strcmp(argv[i], "--format") == 0 && i + 1 < argc) recordFormat = argv[++i];
+		if (std::strcmp(argv[i], "--orbit") == 0) orbit = GL_TRUE;
+
+		// render with the cpu rasterizer instead of opening a window
+		if (std::strcmp(argv[i], "--soft-raster") == 0) softRaster = GL_TRUE;
+
+		// generate the shapes in the vertex shader instead of uploading meshes
+		if (std::strcmp(argv[i], "--procedural") == 0) procedural = GL_TRUE;
+
+		// top, front, side and perspective view in one pass
+		if (std::strcmp(argv[i], "--quad-view") == 0) quadView = GL_TRUE;
+
+		if (std::strcmp(argv[i], "--fxaa") == 0) fxaa = GL_TRUE;
+		// bounding boxes and axes of the scene nodes, drawn with the debug lines
+		if (std::strcmp(argv[i], "--show-bounds") == 0) showBounds = GL_TRUE;
+
+		if (std::strcmp(argv[i], "--render-thread") == 0) renderThreaded = GL_TRUE;
+		if (std::strcmp(argv[i], "--async-meshes") == 0) asyncMeshes = GL_TRUE;
+
+		if (std::strcmp(argv[i], "--dynamic-res") == 0) dynamicTargetMs = (i + 1 < argc && std::atof(argv[i + 1]) > 0.0) ? std::atof(argv[++i]) : 16.0;
+	}
+
+	// the multi view shader reads vertex buffers, the procedural shapes have none
+	if (quadView && procedural) {
+		std::cout << "--procedural is ignored with --quad-view" << std::endl;
+		procedural = GL_FALSE;
+	}
+
+	// the procedural shapes have nothing to generate or upload
+	if (procedural && asyncMeshes) {
+		std::cout << "--async-meshes is ignored with --procedural" << std::endl;
+		asyncMeshes = GL_FALSE;
+	}
+
+	if (softRaster) return softwareRender(headlessFrames, screenshotPath, modelPath);
+
 	// initialize glfw and set window hints
 	glfwInit();
 	glfwWindowHint(GLFW_CONTEXT_VERSION_MAJOR, 3);
 	glfwWindowHint(GLFW_CONTEXT_VERSION_MINOR, 3);
 	glfwWindowHint(GLFW_OPENGL_PROFILE, GLFW_OPENGL_CORE_PROFILE);
 	glfwWindowHint(GLFW_RESIZABLE, GLFW_TRUE);
-	glfwWindowHint(GLFW_SAMPLES, 2);
+	glfwWindowHint(GLFW_VISIBLE, headless ? GLFW_FALSE : GLFW_TRUE);
 
 	// create a window
 	GLFWwindow* window = glfwCreateWindow(WIN_WIDTH, WIN_HEIGHT, "3D Shapes", nullptr, nullptr);
@@ -129,81 +519,423 @@ int main() {
 	glfwSetScrollCallback(window, scrollCallback);
 	glfwSetWindowSizeCallback(window, windowSizeCallback);
 	glfwSetKeyCallback(window, keyCallback);
+	glfwSetWindowRefreshCallback(window, windowRefreshCallback);
+
+	// vsync paces the loop while something is moving, set a frame cap instead with scheduler.SetFrameCap
+	// headless runs go as fast as they can
+	scheduler.SetVsync(!headless);
+	scheduler.SetAnimating(orbit);
 
 	glfwGetCursorPos(window, &mouse.x, &mouse.y);
 	mouse.middleButton = GL_FALSE;
 
-	glm::mat4 projection = glm::perspective(glm::radians(45.0f), (GLfloat)WIN_WIDTH / (GLfloat)WIN_HEIGHT, 0.01f, 1000.0f);
-	viewCam.projection_mat = projection;
+	setupCamera();
 
-	viewCam.Rotate(-45.0f, glm::vec3(1.0f, 0.0f, 0.0f));
-	viewCam.Rotate(-45.0f, glm::vec3(0.0f, 0.0f, 1.0f));
+	// everything that owns gl objects lives in this scope, so it is destroyed while the context is still current
+	// and before the pool is emptied
+	{
+		// shaders
+		Shader defaultShader("./shaders/defaultVert.glsl", "./shaders/defaultFrag.glsl");
+		Shader proceduralShader("./shaders/proceduralVert.glsl", "./shaders/defaultFrag.glsl");
+		Shader multiViewShader("./shaders/multiViewVert.glsl", "./shaders/defaultFrag.glsl");
 
-	// meshes
-	Disk disk(0.5f, 100);
-	UVSphere sphere1(0.75f, glm::vec3(-2.0f, 0.0f, 0.0f), 128, 64);
-	Torus torus(glm::vec3(2.0f, 0.0f, 0.0f), 0.20f, 0.5f, 32, 96);
-	Trefoil trefoil(glm::vec3(0.0f, 0.0f, 0.0f), 256, 32, 0.17f);
-
-	// empties
-	Line yAxis(glm::vec3(0.0f, -100.0f, 0.0f), glm::vec3(0.0f, 100.0f, 0.0f), 2.0f);
-	Line xAxis(glm::vec3(-100.0f, 0.0f, 0.0f), glm::vec3(100.0f, 0.0f, 0.0f), 2.0f);
-	Grid floor(1.0f, 100, 0.5f);
-
-	// shaders
-	Shader defaultShader("./shaders/defaultVert.glsl", "./shaders/defaultFrag.glsl");
-
-	Shader gridShader("./shaders/gridVert.glsl", "./shaders/gridFrag.glsl");
-	
-	Shader colorRed("./shaders/gridVert.glsl", "./shaders/gridFrag.glsl");
-	Shader colorGreen("./shaders/gridVert.glsl", "./shaders/gridFrag.glsl");
-
-	// modifications and other declarations
-	disk.SetShader(defaultShader.Program);
-	sphere1.SetShader(defaultShader.Program);
-	torus.SetShader(defaultShader.Program);
-	trefoil.SetShader(defaultShader.Program);
-
-	yAxis.SetShader(colorGreen.Program, glm::vec4(0.0f, 1.0f, 0.0f, 1.0f));
-	xAxis.SetShader(colorRed.Program, glm::vec4(1.0f, 0.0f, 0.0f, 1.0f));
-	floor.SetShader(gridShader.Program, glm::vec4(0.7f, 0.7f, 0.7f, 0.25f));
-
-	std::vector <glm::vec3> lightPos {
-		glm::vec3(0.0f, 30.0f, 30.0f),
-		glm::vec3(30.0f, -30.0f, 0.0f),
-		glm::vec3(-30.0f, 0.0f, -30.0f)
-	};
+		Shader gridShader("./shaders/gridVert.glsl", "./shaders/gridFrag.glsl");
+		Shader debugShader("./shaders/debugVert.glsl", "./shaders/debugFrag.glsl");
+
+		GLuint shapeProgram = procedural ? proceduralShader.Program : defaultShader.Program;
+
+		// meshes, generated on the first run and memory mapped from ./cache afterwards
+		// with --async-meshes they are built in the background and drawn as they become ready, coarse versions first
+		std::chrono::steady_clock::time_point meshStart = std::chrono::steady_clock::now();
+
+		MeshLoader loader(asyncMeshes ? window : nullptr);
+
+		SceneGraph scene;
+		SceneNode shapesNode = scene.Create();
+
+		std::vector <LoadingSceneMesh> sceneMeshes;
+
+		Disk disk(0.5f, 100);
+
+		// --procedural evaluates the same shapes in the vertex shader, without any vertex or index data
+		if (procedural) {
+			sceneMeshes.push_back({ { loader.Request <ProceduralTrefoil>(shapeProgram, glm::vec3(0.0f, 0.0f, 0.0f), 256, 32, 0.17f) }, scene.Create(shapesNode) });
+			sceneMeshes.push_back({ { loader.Request <ProceduralSphere>(shapeProgram, 0.75f, glm::vec3(-2.0f, 0.0f, 0.0f), 128, 64) }, scene.Create(shapesNode) });
+			sceneMeshes.push_back({ { loader.Request <ProceduralTorus>(shapeProgram, glm::vec3(2.0f, 0.0f, 0.0f), 0.20f, 0.5f, 32, 96) }, scene.Create(shapesNode) });
+		}
+		else {
+			std::vector <MeshHandle> trefoilLevels, sphereLevels, torusLevels;
+
+			// a few hundred triangles each, ready long before the full meshes
+			if (loader.Async()) {
+				trefoilLevels.push_back(loader.Request <Trefoil>(shapeProgram, glm::vec3(0.0f, 0.0f, 0.0f), 16.0f * tubeTolerance(), 8, 0.17f));
+				sphereLevels.push_back(loader.Request <UVSphere>(shapeProgram, 0.75f, glm::vec3(-2.0f, 0.0f, 0.0f), 16, 8));
+				torusLevels.push_back(loader.Request <Torus>(shapeProgram, glm::vec3(2.0f, 0.0f, 0.0f), 0.20f, 0.5f, 8, 24));
+			}
+
+			trefoilLevels.push_back(loader.Request <Trefoil>(shapeProgram, glm::vec3(0.0f, 0.0f, 0.0f), tubeTolerance(), 32, 0.17f));
+			sphereLevels.push_back(loader.Request <UVSphere>(shapeProgram, 0.75f, glm::vec3(-2.0f, 0.0f, 0.0f), 128, 64));
+			torusLevels.push_back(loader.Request <Torus>(shapeProgram, glm::vec3(2.0f, 0.0f, 0.0f), 0.20f, 0.5f, 32, 96));
+
+			sceneMeshes.push_back({ trefoilLevels, scene.Create(shapesNode) });
+			sceneMeshes.push_back({ sphereLevels, scene.Create(shapesNode) });
+			sceneMeshes.push_back({ torusLevels, scene.Create(shapesNode) });
+		}
+
+		if (!loader.Async()) {
+			glFinish();
+			GLdouble meshMs = std::chrono::duration<GLdouble, std::milli>(std::chrono::steady_clock::now() - meshStart).count();
+
+			std::cout << "meshes ready in " << meshMs << " ms (" << MeshCache::hits << " cached, " << MeshCache::misses << " generated)" << std::endl;
+		}
+
+		if (modelPath != nullptr) {
+			std::chrono::steady_clock::time_point importStart = std::chrono::steady_clock::now();
+
+			MeshHandle model = loader.Request <ImportedMesh>(defaultShader.Program, modelPath, glm::vec3(0.0f, 0.0f, 1.5f));
+
+			GLdouble importMs = std::chrono::duration<GLdouble, std::milli>(std::chrono::steady_clock::now() - importStart).count();
+			if (model.Ready()) std::cout << "imported " << modelPath << " (" << model.Get()->triCount << " triangles) in " << importMs << " ms" << std::endl;
+
+			if (!model.Failed()) sceneMeshes.push_back({ { model }, scene.Create(shapesNode) });
+		}
+
+		// empties, the axes and everything else made of loose lines go through debugDraw each frame
+		Grid floor(1.0f, 100, 0.5f);
+		DebugDraw debugDraw;
+
+		// modifications and other declarations
+		disk.SetShader(defaultShader.Program);
+
+		debugDraw.SetShader(debugShader.Program);
+		floor.SetShader(gridShader.Program, glm::vec4(0.7f, 0.7f, 0.7f, 0.25f));
+
+		for (GLuint program : { (GLuint)defaultShader.Program, (GLuint)proceduralShader.Program, (GLuint)multiViewShader.Program }) {
+			glUseProgram(program);
+				glUniform3f(glGetUniformLocation(program, "lightPosition[0]"), lightPos[0].x, lightPos[0].y, lightPos[0].z);
+				glUniform3f(glGetUniformLocation(program, "lightPosition[1]"), lightPos[1].x, lightPos[1].y, lightPos[1].z);
+				glUniform3f(glGetUniformLocation(program, "lightPosition[2]"), lightPos[2].x, lightPos[2].y, lightPos[2].z);
+			glUseProgram(0);
+		}
+
+		// cameras looking down, along +y and along -x at the origin
+		MultiView multiView;
+		multiView.SetShader(multiViewShader.Program);
+
+		Camera axisCams[3] = { Camera(glm::vec3(0.0f, 0.0f, -10.0f)), Camera(glm::vec3(0.0f, 0.0f, -10.0f)), Camera(glm::vec3(0.0f, 0.0f, -10.0f)) };
+		axisCams[1].Rotate(-90.0f, glm::vec3(1.0f, 0.0f, 0.0f));
+		axisCams[2].Rotate(-90.0f, glm::vec3(1.0f, 0.0f, 0.0f));
+		axisCams[2].Rotate(-90.0f, glm::vec3(0.0f, 0.0f, 1.0f));
+
+		// the scene is drawn offscreen with 2x msaa, resolved, then copied to the window and read back by captures
+		// with post processing it is drawn single sampled, possibly at a lower resolution, and upscaled with fxaa into outputTarget
+		GLboolean postProcessing = fxaa || dynamicTargetMs > 0.0;
+
+		RenderTarget sceneTarget(WIN_WIDTH, WIN_HEIGHT, postProcessing ? 1 : 2);
+
+		std::unique_ptr <RenderTarget>		outputTarget;
+		std::unique_ptr <PostProcess>		postProcess;
+		std::unique_ptr <DynamicResolution> resolution;
+
+		if (postProcessing) {
+			outputTarget.reset(new RenderTarget(WIN_WIDTH, WIN_HEIGHT, 1));
+			postProcess.reset(new PostProcess());
+		}
+
+		if (dynamicTargetMs > 0.0) resolution.reset(new DynamicResolution(dynamicTargetMs));
+		FrameCapture capture;
+
+		if (!screenshotPath.empty()) capture.Screenshot(screenshotPath);
+		if (!recordDirectory.empty()) capture.StartSequence(recordDirectory, recordFormat);
+
+		// framesDrawn is counted by the renderer, only read it once the loop is over
+		GLuint	 framesDrawn	 = 0;
+		GLuint	 framesSubmitted = 0;
+		GLuint64 meshesCulled	 = 0;
+
+		// loader.ready when the last packet was built, a mesh that finished since is not on screen yet
+		GLuint meshesInPacket = 0;
+
+		// set by the renderer while a screenshot or readback is still waiting to be handed to the encoders
+		std::atomic <GLboolean> capturing { GL_FALSE };
+
+		glEnable(GL_DEPTH_TEST);
+		glEnable(GL_MULTISAMPLE);
+		glEnable(GL_BLEND);
+		glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
+
+		// fills a packet from the simulation, on the main thread since glfw only delivers input there
+		// the meshes are left alone, their model matrices travel in the packet and are set by the renderer
+		auto buildPacket = [&](FramePacket& packet) {
+			scene.Update();
+
+			// read before the handles, a mesh counted here is ready for Finest
+			meshesInPacket = loader.ready;
+
+			packet.frame  = framesSubmitted;
+			packet.width  = WIN_WIDTH;
+			packet.height = WIN_HEIGHT;
+			packet.camera = viewCam;
+
+			packet.draws.clear();
+			packet.culled = 0;
+
+			// the quad view culls against each of its views itself
+			Frustum frustum(viewCam.projection_mat * viewCam.GetViewMat());
+
+			for (const LoadingSceneMesh& entry : sceneMeshes) {
+				MeshObject* mesh = entry.Finest();
+				if (mesh == nullptr) { continue; }
+
+				DrawItem item = { mesh, scene.World(entry.node) };
 
-	glUseProgram(disk.shaderProgram);
-		glUniform3f(glGetUniformLocation(trefoil.shaderProgram, "lightPosition[0]"), lightPos[0].x, lightPos[0].y, lightPos[0].z);
-		glUniform3f(glGetUniformLocation(trefoil.shaderProgram, "lightPosition[1]"), lightPos[1].x, lightPos[1].y, lightPos[1].z);
-		glUniform3f(glGetUniformLocation(trefoil.shaderProgram, "lightPosition[2]"), lightPos[2].x, lightPos[2].y, lightPos[2].z);
-	glUseProgram(0);
+				glm::vec3 center, extent;
+				Frustum::WorldBox(item.model, mesh->boundsMin, mesh->boundsMax, center, extent);
 
-	glEnable(GL_DEPTH_TEST);
-	glEnable(GL_MULTISAMPLE);
-	glEnable(GL_BLEND);
-	glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
+				if (!quadView && !frustum.Intersects(center, extent)) {
+					packet.culled++;
+					continue;
+				}
 
-	// game loop
-	while (!glfwWindowShouldClose(window)) {
-		glfwPollEvents();
+				packet.draws.push_back(item);
+			}
 
-		glClearColor(0.08f, 0.08f, 0.08f, 1.0f);
-		glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+			packet.screenshot	   = screenshotRequested;
+			packet.toggleRecording = recordingToggled;
+			packet.toggleOverlay   = overlayToggled;
+			packet.dumpTrace	   = traceRequested;
 
-		floor.Draw(viewCam);
+			screenshotRequested = recordingToggled = overlayToggled = traceRequested = GL_FALSE;
 
-		trefoil.Draw(viewCam);
-		sphere1.Draw(viewCam);
-		torus.Draw(viewCam);
+			// taken last so the latency covers everything from input to the swap
+			packet.sampled = std::chrono::steady_clock::now();
+		};
 
-		yAxis.Draw(viewCam);
-		xAxis.Draw(viewCam);
+		// draws one packet, on whichever thread has the context current
+		auto renderFrame = [&](const FramePacket& packet) {
+			// meshes finished here are in the packets built from now on
+			if (loader.Poll() > 0 && loader.Pending() == 0) {
+				GLdouble meshMs = std::chrono::duration<GLdouble, std::milli>(std::chrono::steady_clock::now() - meshStart).count();
+				std::cout << "meshes ready in " << meshMs << " ms (" << MeshCache::hits << " cached, " << MeshCache::misses << " generated)" << std::endl;
+			}
 
-		glfwSwapBuffers(window);
+			if (packet.screenshot) capture.Screenshot(nextScreenshotPath());
+
+			if (packet.toggleRecording) {
+				if (capture.Recording()) capture.StopSequence();
+				else capture.StartSequence("./capture", recordFormat);
+			}
+
+			if (packet.toggleOverlay) { PROFILE_TOGGLE_OVERLAY(); }
+			if (packet.dumpTrace) { PROFILE_DUMP_TRACE("profile_trace.json"); }
+
+			PROFILE_BEGIN_FRAME();
+
+			sceneTarget.Resize(packet.width, packet.height);
+			if (resolution) sceneTarget.SetViewSize(resolution->Scaled(packet.width), resolution->Scaled(packet.height));
+
+			sceneTarget.Bind();
+
+			GLint viewWidth	 = sceneTarget.viewWidth;
+			GLint viewHeight = sceneTarget.viewHeight;
+
+			if (resolution) resolution->Begin();
+
+			{
+				PROFILE_SCOPE("clear");
+
+				glClearColor(0.08f, 0.08f, 0.08f, 1.0f);
+				glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+			}
+
+			// grid and axes only go to the perspective quarter of the quad view
+			if (quadView) glViewport(viewWidth / 2, 0, viewWidth - viewWidth / 2, viewHeight / 2);
+
+			{
+				PROFILE_SCOPE("grid pass");
+
+				floor.Draw(packet.camera);
+			}
+
+			for (const DrawItem& item : packet.draws) item.mesh->model_mat = item.model;
+
+			if (quadView) {
+				PROFILE_SCOPE("mesh pass");
+
+				glViewport(0, 0, viewWidth, viewHeight);
+
+				setQuadViews(multiView, axisCams, packet.camera, packet.width, packet.height);
+				multiView.Begin();
+
+				for (const DrawItem& item : packet.draws) multiView.Draw(*item.mesh);
+
+				multiView.End();
+				glViewport(viewWidth / 2, 0, viewWidth - viewWidth / 2, viewHeight / 2);
+			}
+			else {
+				PROFILE_SCOPE("mesh pass");
+
+				for (const DrawItem& item : packet.draws) item.mesh->Draw(packet.camera);
+			}
+
+			{
+				PROFILE_SCOPE("axis pass");
+
+				debugDraw.Line(glm::vec3(0.0f, -100.0f, 0.0f), glm::vec3(0.0f, 100.0f, 0.0f), glm::vec4(0.0f, 1.0f, 0.0f, 0.75f), 2.0f, GL_TRUE);
+				debugDraw.Line(glm::vec3(-100.0f, 0.0f, 0.0f), glm::vec3(100.0f, 0.0f, 0.0f), glm::vec4(1.0f, 0.0f, 0.0f, 0.75f), 2.0f, GL_TRUE);
+
+				if (showBounds) {
+					for (const DrawItem& item : packet.draws) {
+						debugDraw.Box(item.mesh->boundsMin, item.mesh->boundsMax, glm::vec4(1.0f, 0.8f, 0.2f, 1.0f), item.model);
+						debugDraw.Axes(item.model, 0.5f);
+					}
+				}
+
+				debugDraw.Flush(packet.camera);
+			}
+
+			if (quadView) glViewport(0, 0, viewWidth, viewHeight);
+
+			if (resolution) resolution->End();
+
+			{
+				PROFILE_SCOPE("resolve");
+
+				RenderTarget* output = &sceneTarget;
+				GLuint resolved = sceneTarget.Resolve();
+
+				if (postProcess) {
+					PROFILE_SCOPE("post process");
+
+					outputTarget->Resize(packet.width, packet.height);
+					postProcess->Apply(sceneTarget, *outputTarget);
+
+					output	 = outputTarget.get();
+					resolved = outputTarget->Resolve();
+				}
+
+				if (capture.Active()) capture.Capture(resolved, output->width, output->height);
+
+				if (!headless) output->BlitToScreen(packet.width, packet.height);
+			}
+
+			// drawn on the window only, captures never contain the overlay
+			PROFILE_DRAW_OVERLAY(packet.width, packet.height);
+
+			if (!headless) {
+				PROFILE_SCOPE("swap");
+
+				glfwSwapBuffers(window);
+			}
+
+			PROFILE_END_FRAME();
+
+			if (framesDrawn == 0) {
+				GLdouble firstMs = std::chrono::duration<GLdouble, std::milli>(std::chrono::steady_clock::now() - launchTime).count();
+				std::cout << "first frame after " << firstMs << " ms, " << loader.ready << " of " << loader.requested << " meshes ready" << std::endl;
+			}
+
+			framesDrawn++;
+
+			// readbacks are only retired by the next Capture, so the loop has to keep drawing until they are
+			capturing = capture.Active();
+			if (renderThreaded && capturing) glfwPostEmptyEvent();
+		};
+
+		// with --render-thread the context moves to the render thread for the whole loop and comes back afterwards
+		RenderThread renderThread;
+		FramePacket	 localPacket;
+		LatencyStats latency;
+
+		if (renderThreaded) {
+			glfwMakeContextCurrent(nullptr);
+			renderThread.Start(window, renderFrame);
+		}
+
+		// game loop
+		scheduler.Start();
+
+		std::chrono::steady_clock::time_point loopStart = std::chrono::steady_clock::now();
+
+		while (!glfwWindowShouldClose(window)) {
+			if (headless) {
+				if (framesSubmitted == headlessFrames) { break; }
+
+				update(HEADLESS_STEP);
+			}
+			else {
+				// the loader posts an empty event for every finished upload, keep drawing until they are all on screen
+				if (loader.Pending() > 0 || loader.ready != meshesInPacket) scheduler.RequestRedraw();
+				if (capturing) scheduler.RequestRedraw();
+
+				scheduler.WaitForEvents();
+
+				GLuint steps = scheduler.Advance();
+				for (GLuint i = 0; i < steps; i++) {
+					update(scheduler.fixedStep);
+				}
+
+				if (!scheduler.ShouldDraw()) { continue; }
+			}
+
+			// waits while the render thread is still on the packet before last
+			FramePacket& packet = renderThreaded ? renderThread.Packet() : localPacket;
+			buildPacket(packet);
+			meshesCulled += packet.culled;
+
+			// the render thread draws it while the next one is built
+			if (renderThreaded) {
+				renderThread.Submit();
+			}
+			else {
+				renderFrame(packet);
+				latency.Add(packet);
+			}
+
+			scheduler.EndFrame();
+			framesSubmitted++;
+		}
+
+		if (renderThreaded) {
+			renderThread.Stop();
+			glfwMakeContextCurrent(window);
+
+			latency = renderThread.latency;
+		}
+
+		// headless runs report throughput, comparable with --soft-raster when the gl driver is llvmpipe
+		if (headless && framesDrawn > 0) {
+			glFinish();
+
+			GLdouble seconds = std::chrono::duration<GLdouble>(std::chrono::steady_clock::now() - loopStart).count();
+			GLuint sceneTriangles = 0;
+			for (const LoadingSceneMesh& entry : sceneMeshes) sceneTriangles += entry.Finest() ? entry.Finest()->triCount : 0;
+
+			GLdouble triangles = (GLdouble)sceneTriangles * framesDrawn;
+			GLdouble pixels = (GLdouble)sceneTarget.viewWidth * sceneTarget.viewHeight * framesDrawn;
+
+			std::cout << (const char*)glGetString(GL_RENDERER) << ": " << sceneTarget.width << "x" << sceneTarget.height << ", " << framesDrawn << " frames\n";
+			std::cout << "  " << seconds * 1000.0 / framesDrawn << " ms/frame, " << triangles / seconds / 1e6 << " Mtris/s, " << pixels / seconds / 1e6 << " Mpix/s" << std::endl;
+
+			if (resolution) std::cout << "  dynamic resolution: scale " << resolution->scale << ", " << resolution->gpuMs << " ms gpu for the scene, target " << resolution->targetMs << " ms" << std::endl;
+			if (quadView) std::cout << "  quad view: " << multiView.drawCount << " draw calls for " << multiView.viewCount << " views, " << multiView.culledCount << " mesh views culled" << std::endl;
+			else std::cout << "  " << meshesCulled << " mesh draws culled" << std::endl;
+		}
+
+		// from sampling the simulation to the swap, about one frame more with the render thread in exchange for the overlap
+		if ((headless || renderThreaded) && latency.frames > 0) {
+			std::cout << (renderThreaded ? "render thread" : "single thread") << " latency: " << latency.AverageMs() << " ms average, " << latency.maxMs << " ms max over " << latency.frames << " frames" << std::endl;
+		}
+
+		capture.Shutdown();
+		if (capture.framesCaptured > 0) std::cout << "captured " << capture.framesCaptured << " frames" << std::endl;
+
+		loader.Shutdown();
 	}
 
+	PROFILE_SHUTDOWN();
+	GLResourcePool::Clear();
+
 	glfwTerminate();
 	return 0;
 }
\ No newline at end of file
@@ -0,0 +1,328 @@
+// cpu side hot paths of the app, measured without a window or gl context and written as json
+//
+//	cpu_benchmarks [--filter <substring>] [--min-time <seconds>] [--label <text>] [--out <file.json>]
+//
+// every benchmark is timed in samples of a calibrated number of iterations, the median and the fastest
+// sample per iteration are reported, compare the median between commits
+
+#include "../include/3d_shapes.h"
+#include "../include/camera.hpp"
+#include "../include/mesh_cache.hpp"
+#include "../include/mesh_object.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <functional>
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+
+// text as the inside of a json string literal
+std::string jsonEscape(const std::string& text) {
+	std::string escaped;
+	escaped.reserve(text.size());
+
+	for (char c : text) {
+		if (c == '"' || c == '\\') {
+			escaped += '\\';
+			escaped += c;
+		}
+		else if ((unsigned char)c < 0x20) {
+			char code[8];
+			std::snprintf(code, sizeof(code), "\\u%04x", (unsigned)c);
+			escaped += code;
+		}
+		else {
+			escaped += c;
+		}
+	}
+
+	return escaped;
+}
+
+struct BenchmarkResult {
+	std::string name;
+
+	GLuint64 iterations;
+	GLdouble medianNs;		// per iteration
+	GLdouble minNs;
+	GLdouble itemsPerSecond;	// vertices, indices or matrices, whatever the benchmark produces
+};
+
+class BenchmarkRunner {
+private:
+	static constexpr GLuint SAMPLES = 15;
+
+	std::string filter;
+	GLdouble	minTime;
+
+	// written by benchmarks whose results would otherwise be optimized away
+	volatile GLfloat sink;
+
+	template <typename Body>
+	static GLdouble Time(GLuint64 iterations, Body& body) {
+		std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+		for (GLuint64 i = 0; i < iterations; i++) body();
+
+		return std::chrono::duration<GLdouble, std::nano>(std::chrono::steady_clock::now() - start).count();
+	}
+
+public:
+	std::vector <BenchmarkResult> results;
+	GLuint failed;		// benchmarks that were skipped or could not be timed, reported on stderr and left out of the json
+
+	BenchmarkRunner(const std::string& filter, GLdouble minTime) {
+		this->filter  = filter;
+		this->minTime = minTime;
+		this->sink	  = 0.0f;
+		this->failed  = 0;
+	}
+
+	GLboolean Selected(const std::string& name) const {
+		return filter.empty() || name.find(filter) != std::string::npos;
+	}
+
+	void Fail(const std::string& name, const std::string& reason) {
+		std::cerr << "ERROR::BENCHMARK::" << reason << " " << name << std::endl;
+		failed++;
+	}
+
+	void Consume(GLfloat value) {
+		sink = sink + value;
+	}
+
+	// items is what one iteration produces, for the throughput column
+	template <typename Body>
+	void Run(const std::string& name, GLdouble items, Body body) {
+		if (!Selected(name)) { return; }
+
+		std::cerr << name << std::endl;
+
+		// doubles the batch until one sample takes its share of the minimum time, which also warms the caches
+		GLdouble sampleNs = minTime * 1e9 / SAMPLES;
+		GLuint64 batch = 1;
+
+		while (Time(batch, body) < sampleNs && batch < (1ull << 40)) batch *= 2;
+
+		std::vector <GLdouble> perIteration(SAMPLES);
+		for (GLuint i = 0; i < SAMPLES; i++) perIteration[i] = Time(batch, body) / batch;
+
+		std::sort(perIteration.begin(), perIteration.end());
+
+		GLdouble median = perIteration[SAMPLES / 2];
+
+		// below the clock's resolution there is nothing to compare, and the throughput would be infinite
+		if (!(median > 0.0)) {
+			Fail(name, "ZERO_MEDIAN");
+			return;
+		}
+
+		results.push_back({ name, batch * SAMPLES, median, perIteration[0], items * 1e9 / median });
+	}
+
+	std::string Json(const std::string& label) const {
+		std::ostringstream out;
+		out.precision(6);
+
+		out << "{\n";
+		out << "  \"context\": {\n";
+		out << "    \"label\": \"" << jsonEscape(label) << "\",\n";
+		out << "    \"compiler\": \"" << jsonEscape(__VERSION__) << "\",\n";
+		out << "    \"hardware_threads\": " << std::thread::hardware_concurrency() << ",\n";
+		out << "    \"samples\": " << SAMPLES << "\n";
+		out << "  },\n";
+		out << "  \"benchmarks\": [\n";
+
+		for (size_t i = 0; i < results.size(); i++) {
+			const BenchmarkResult& result = results[i];
+
+			out << "    { \"name\": \"" << jsonEscape(result.name) << "\", \"iterations\": " << result.iterations
+				<< ", \"median_ns\": " << result.medianNs << ", \"min_ns\": " << result.minNs
+				<< ", \"items_per_second\": " << result.itemsPerSecond << " }" << (i + 1 < results.size() ? "," : "") << "\n";
+		}
+
+		out << "  ]\n";
+		out << "}\n";
+
+		return out.str();
+	}
+};
+
+// GenerateVertices of one mesh over and over, the arrays are allocated once by the constructor
+void generatorBenchmarks(BenchmarkRunner& runner) {
+	for (GLuint resolution : { 16u, 256u, 4096u }) {
+		Disk disk(0.5f, resolution);
+		runner.Run("generate/disk/" + std::to_string(resolution), disk.vertCount, [&]() { disk.Generate(); });
+	}
+
+	for (GLuint divX : { 16u, 64u, 256u }) {
+		UVSphere sphere(0.75f, glm::vec3(-2.0f, 0.0f, 0.0f), divX, divX / 2);
+		runner.Run("generate/uvsphere/" + std::to_string(divX) + "x" + std::to_string(divX / 2), sphere.vertCount, [&]() { sphere.Generate(); });
+	}
+
+	for (GLuint divR : { 8u, 32u, 128u }) {
+		Torus torus(glm::vec3(2.0f, 0.0f, 0.0f), 0.20f, 0.5f, divR, 3 * divR);
+		runner.Run("generate/torus/" + std::to_string(divR) + "x" + std::to_string(3 * divR), torus.vertCount, [&]() { torus.Generate(); });
+	}
+
+	// tolerances in world units, 0.002 is about half a pixel at the starting camera of the app
+	for (GLfloat tolerance : { 0.01f, 0.002f, 0.0005f }) {
+		char suffix[16];
+		std::snprintf(suffix, sizeof(suffix), "%g", tolerance);
+
+		Trefoil trefoil(glm::vec3(0.0f, 0.0f, 0.0f), tolerance, 32, 0.17f);
+		ClosedCurve curve = Trefoil::Curve(glm::vec3(0.0f, 0.0f, 0.0f), 1.0f);
+
+		runner.Run(std::string("generate/trefoil/") + suffix, trefoil.vertCount, [&]() { trefoil.Generate(); });
+		runner.Run(std::string("sample/trefoil/") + suffix, trefoil.RingCount(), [&]() {
+			runner.Consume(TubeMesh::SampleAdaptive(curve, 0.17f, tolerance).back());
+		});
+	}
+
+	TorusKnot knot(glm::vec3(0.0f, 0.0f, 0.0f), 3, 5, 0.002f, 32, 0.1f, 1.0f);
+	runner.Run("generate/torusknot/3_5", knot.vertCount, [&]() { knot.Generate(); });
+}
+
+void indexBenchmarks(BenchmarkRunner& runner) {
+	for (GLuint rings : { 32u, 256u, 1024u }) {
+		std::vector <GLuint> indices(6 * (size_t)rings * 32);
+
+		runner.Run("indices/closed_grid/" + std::to_string(rings) + "x32", (GLdouble)indices.size(), [&]() {
+			MeshObject::ClosedGridIndices(rings, 32, indices.data());
+			runner.Consume((GLfloat)indices.back());
+		});
+	}
+}
+
+// what update() and SetMats do with the camera every frame
+void cameraBenchmarks(BenchmarkRunner& runner) {
+	Camera camera(glm::vec3(0.0f, 0.0f, -6.0f));
+	camera.projection_mat = glm::perspective(glm::radians(45.0f), 1.0f, 0.01f, 1000.0f);
+
+	runner.Run("camera/orbit_and_move", 1, [&]() {
+		camera.Rotate(0.25f, glm::vec3(0.0f, 0.0f, 1.0f));
+		camera.RotateLocalX(0.125f);
+		camera.TranslateLocal(0.01f, cameraDirection::front);
+
+		runner.Consume(camera.GetViewMat()[3].x);
+	});
+
+	runner.Run("camera/view_projection", 1, [&]() {
+		camera.target_vec.x += 1e-7f;
+		runner.Consume((camera.projection_mat * camera.GetViewMat())[2].z);
+	});
+
+	glm::mat4 model = glm::rotate(glm::mat4(1.0f), 0.3f, glm::vec3(0.0f, 1.0f, 0.0f));
+
+	// the 4x4 inverse SetMats uses, against inverting only the 3x3 part
+	runner.Run("normal_matrix/mat4_inverse", 1, [&]() {
+		model[3].x += 1e-7f;
+		runner.Consume(glm::mat3(glm::transpose(glm::inverse(camera.GetViewMat() * model)))[1].y);
+	});
+
+	runner.Run("normal_matrix/mat3_inverse", 1, [&]() {
+		model[3].x += 1e-7f;
+		runner.Consume(glm::transpose(glm::inverse(glm::mat3(camera.GetViewMat() * model)))[1].y);
+	});
+}
+
+// the cpu half of getting a mesh onto the gpu: hashing the cache key, mapping and validating the cache file,
+// and the copy glBufferSubData makes from it
+void uploadBenchmarks(BenchmarkRunner& runner) {
+	runner.Run("upload/cache_key/uvsphere", 1, [&]() {
+		MeshCacheKey key = MeshCacheKey("uvsphere") << 0.75f << glm::vec3(-2.0f, 0.0f, 0.0f) << 128u << 64u;
+		runner.Consume((GLfloat)(key.hash & 0xff));
+	});
+
+	std::error_code error;
+
+	std::string previousDirectory = MeshCache::directory;
+	std::filesystem::path directory = std::filesystem::temp_directory_path(error) / "3d_shapes_bench_cache";
+
+	MeshCache::directory = directory.string();
+	MeshCache::enabled	 = GL_TRUE;
+
+	for (GLuint divX : { 64u, 256u }) {
+		std::string name = "upload/cache_load/uvsphere/" + std::to_string(divX) + "x" + std::to_string(divX / 2);
+		if (!runner.Selected(name)) { continue; }
+
+		if (error) {
+			runner.Fail(name, "NO_TEMP_DIRECTORY");
+			continue;
+		}
+
+		MeshCacheKey key = MeshCacheKey("uvsphere") << 0.75f << glm::vec3(-2.0f, 0.0f, 0.0f) << divX << divX / 2;
+
+		// the constructor stores it in the temporary cache
+		UVSphere sphere(0.75f, glm::vec3(-2.0f, 0.0f, 0.0f), divX, divX / 2);
+		std::vector <GLfloat> staging(sphere.vertices.size());
+
+		// without the file every iteration would time a failed open instead of a load
+		CachedMesh probe;
+		if (!MeshCache::Load(key, sphere.vertCount, sphere.triCount, 6, probe)) {
+			runner.Fail(name, "CACHE_NOT_WRITTEN");
+			continue;
+		}
+
+		runner.Run(name, sphere.vertCount, [&]() {
+			CachedMesh cached;
+			MeshCache::Load(key, sphere.vertCount, sphere.triCount, 6, cached);
+
+			std::memcpy(staging.data(), cached.vertices, staging.size() * sizeof(GLfloat));
+			runner.Consume(staging.back());
+		});
+	}
+
+	if (!error) std::filesystem::remove_all(directory, error);
+
+	MeshCache::directory = previousDirectory;
+	MeshCache::enabled	 = GL_FALSE;
+}
+
+int main(int argc, char** argv) {
+	std::string filter;
+	std::string label;
+	std::string outPath;
+	GLdouble	minTime = 0.2;
+
+	for (int i = 1; i < argc; i++) {
+		if (std::strcmp(argv[i], "--filter") == 0 && i + 1 < argc) filter = argv[++i];
+		if (std::strcmp(argv[i], "--min-time") == 0 && i + 1 < argc) minTime = std::atof(argv[++i]);
+		if (std::strcmp(argv[i], "--label") == 0 && i + 1 < argc) label = argv[++i];
+		if (std::strcmp(argv[i], "--out") == 0 && i + 1 < argc) outPath = argv[++i];
+	}
+
+	// meshes stay on the cpu and are generated every time, no gl function is ever called
+	MeshObject::cpuOnly = GL_TRUE;
+	MeshCache::enabled	= GL_FALSE;
+
+	BenchmarkRunner runner(filter, minTime);
+
+	generatorBenchmarks(runner);
+	indexBenchmarks(runner);
+	cameraBenchmarks(runner);
+	uploadBenchmarks(runner);
+
+	std::string json = runner.Json(label);
+
+	if (outPath.empty()) {
+		std::cout << json;
+		return (runner.failed > 0) ? -1 : 0;
+	}
+
+	std::ofstream file(outPath);
+	if (!file.is_open()) {
+		std::cout << "Failed to write " << outPath << std::endl;
+		return -1;
+	}
+
+	file << json;
+	return (runner.failed > 0) ? -1 : 0;
+}
\ No newline at end of file
@@ -0,0 +1,230 @@
+#pragma once
+
+#include "3d_shapes.h"
+#include "camera.hpp"
+#include "profiler.hpp"
+#include "gl_resource.hpp"
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+// colored line segments collected during a frame and drawn by Flush, see debugVert.glsl
+// everything goes into one streaming buffer uploaded once per frame, with one draw call per line width and depth mode
+class DebugDraw {
+private:
+	struct Vertex {
+		glm::vec3 position;
+		uint32_t  color;	// rgba8, red in the lowest byte
+	};
+
+	struct Batch {
+		GLfloat	  lineWidth;
+		GLboolean depthTest;
+
+		std::vector <Vertex> vertices;
+	};
+
+	VertexArrayHandle VAO;
+	BufferHandle	  VBO;
+	GLsizeiptr		  capacity;
+
+	// batches keep their memory between frames, most frames only ever use the first one
+	std::vector <Batch> batches;
+	GLuint lastBatch;
+
+	static uint32_t Pack(glm::vec4 color) {
+		glm::vec4 scaled = glm::clamp(color, 0.0f, 1.0f) * 255.0f + 0.5f;
+
+		return (uint32_t)scaled.r | ((uint32_t)scaled.g << 8) | ((uint32_t)scaled.b << 16) | ((uint32_t)scaled.a << 24);
+	}
+
+	std::vector <Vertex>& Select(GLfloat lineWidth, GLboolean depthTest) {
+		if (lastBatch < batches.size() && batches[lastBatch].lineWidth == lineWidth && batches[lastBatch].depthTest == depthTest) {
+			return batches[lastBatch].vertices;
+		}
+
+		for (lastBatch = 0; lastBatch < batches.size(); lastBatch++) {
+			if (batches[lastBatch].lineWidth == lineWidth && batches[lastBatch].depthTest == depthTest) { return batches[lastBatch].vertices; }
+		}
+
+		batches.push_back({ lineWidth, depthTest, {} });
+		return batches.back().vertices;
+	}
+
+	// a circle of segments lines around center, spanned by the unit vectors u and v
+	void Circle(glm::vec3 center, glm::vec3 u, glm::vec3 v, GLuint segments, uint32_t color, std::vector <Vertex>& out) {
+		// the point is turned by a fixed step instead of calling sin and cos for every segment
+		GLfloat stepCos = std::cos(glm::two_pi<GLfloat>() / segments);
+		GLfloat stepSin = std::sin(glm::two_pi<GLfloat>() / segments);
+
+		GLfloat c = 1.0f, s = 0.0f;
+		glm::vec3 previous = center + u;
+
+		for (GLuint i = 1; i <= segments; i++) {
+			GLfloat nextC = c * stepCos - s * stepSin;
+			s = s * stepCos + c * stepSin;
+			c = nextC;
+
+			glm::vec3 point = (i == segments) ? center + u : center + c * u + s * v;
+
+			out.push_back({ previous, color });
+			out.push_back({ point, color });
+
+			previous = point;
+		}
+	}
+
+public:
+	// default width and depth mode for everything added without them
+	GLfloat	  lineWidth;
+	GLboolean depthTest;
+
+	GLuint shaderProgram;
+
+	// segments drawn by the last Flush
+	GLuint segmentCount;
+
+	DebugDraw(GLfloat lineWidth = 1.0f) {
+		VAO = VertexArrayHandle::Create();
+		VBO = BufferHandle::Create();
+		capacity = 0;
+
+		glBindVertexArray(VAO);
+
+			glBindBuffer(GL_ARRAY_BUFFER, VBO);
+
+			glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, sizeof(Vertex), (void*)0);
+			glEnableVertexAttribArray(0);
+
+			glVertexAttribPointer(1, 4, GL_UNSIGNED_BYTE, GL_TRUE, sizeof(Vertex), (void*)offsetof(Vertex, color));
+			glEnableVertexAttribArray(1);
+
+		glBindVertexArray(0);
+
+		lastBatch = 0;
+
+		this->lineWidth = lineWidth;
+		this->depthTest = GL_TRUE;
+
+		this->shaderProgram = 0;
+		this->segmentCount	= 0;
+	}
+
+	void SetShader(GLuint program) {
+		this->shaderProgram = program;
+	}
+
+	void Line(glm::vec3 start, glm::vec3 end, glm::vec4 color, GLfloat width, GLboolean depth) {
+		std::vector <Vertex>& out = Select(width, depth);
+		uint32_t packed = Pack(color);
+
+		out.push_back({ start, packed });
+		out.push_back({ end, packed });
+	}
+
+	void Line(glm::vec3 start, glm::vec3 end, glm::vec4 color) {
+		Line(start, end, color, lineWidth, depthTest);
+	}
+
+	// the twelve edges of an axis aligned box, moved by transform
+	void Box(glm::vec3 boundsMin, glm::vec3 boundsMax, glm::vec4 color, const glm::mat4& transform = glm::mat4(1.0f)) {
+		std::vector <Vertex>& out = Select(lineWidth, depthTest);
+		uint32_t packed = Pack(color);
+
+		// corner i takes x, y and z from max where bit 0, 1 and 2 are set
+		glm::vec3 corners[8];
+		for (GLuint i = 0; i < 8; i++) {
+			glm::vec3 corner((i & 1) ? boundsMax.x : boundsMin.x, (i & 2) ? boundsMax.y : boundsMin.y, (i & 4) ? boundsMax.z : boundsMin.z);
+			corners[i] = glm::vec3(transform * glm::vec4(corner, 1.0f));
+		}
+
+		// every corner connects to the ones that differ in a single bit
+		for (GLuint i = 0; i < 8; i++) {
+			for (GLuint bit = 1; bit < 8; bit <<= 1) {
+				if (i & bit) { continue; }
+
+				out.push_back({ corners[i], packed });
+				out.push_back({ corners[i | bit], packed });
+			}
+		}
+	}
+
+	// three great circles
+	void Sphere(glm::vec3 center, GLfloat radius, glm::vec4 color, GLuint segments = 24) {
+		std::vector <Vertex>& out = Select(lineWidth, depthTest);
+		uint32_t packed = Pack(color);
+
+		Circle(center, glm::vec3(radius, 0.0f, 0.0f), glm::vec3(0.0f, radius, 0.0f), segments, packed, out);
+		Circle(center, glm::vec3(0.0f, radius, 0.0f), glm::vec3(0.0f, 0.0f, radius), segments, packed, out);
+		Circle(center, glm::vec3(0.0f, 0.0f, radius), glm::vec3(radius, 0.0f, 0.0f), segments, packed, out);
+	}
+
+	// the x, y and z axes of transform in red, green and blue
+	void Axes(const glm::mat4& transform, GLfloat size = 1.0f) {
+		glm::vec3 origin(transform[3]);
+
+		Line(origin, origin + size * glm::vec3(transform[0]), glm::vec4(1.0f, 0.0f, 0.0f, 1.0f));
+		Line(origin, origin + size * glm::vec3(transform[1]), glm::vec4(0.0f, 1.0f, 0.0f, 1.0f));
+		Line(origin, origin + size * glm::vec3(transform[2]), glm::vec4(0.0f, 0.0f, 1.0f, 1.0f));
+	}
+
+	// uploads everything added since the last flush, draws it with camera and starts over
+	void Flush(Camera camera) {
+		PROFILE_SCOPE("DebugDraw::Flush");
+
+		GLsizeiptr size = 0;
+		for (const Batch& batch : batches) size += batch.vertices.size() * sizeof(Vertex);
+
+		segmentCount = (GLuint)(size / (2 * sizeof(Vertex)));
+		if (size == 0) { return; }
+
+		glBindBuffer(GL_ARRAY_BUFFER, VBO);
+
+		// orphaning lets the driver hand out fresh memory while last frame's lines may still be drawn
+		if (size > capacity) capacity = size + size / 2;
+		glBufferData(GL_ARRAY_BUFFER, capacity, nullptr, GL_STREAM_DRAW);
+
+		GLsizeiptr offset = 0;
+		for (const Batch& batch : batches) {
+			GLsizeiptr bytes = batch.vertices.size() * sizeof(Vertex);
+			if (bytes > 0) glBufferSubData(GL_ARRAY_BUFFER, offset, bytes, batch.vertices.data());
+
+			offset += bytes;
+		}
+
+		glBindBuffer(GL_ARRAY_BUFFER, 0);
+
+		GLboolean wasDepthTest = glIsEnabled(GL_DEPTH_TEST);
+
+		glUseProgram(shaderProgram);
+
+			glm::mat4 viewProjection = camera.projection_mat * camera.GetViewMat();
+			glUniformMatrix4fv(glGetUniformLocation(shaderProgram, "viewProjection"), 1, GL_FALSE, glm::value_ptr(viewProjection));
+
+			glBindVertexArray(VAO);
+
+			GLint first = 0;
+			for (Batch& batch : batches) {
+				GLsizei count = (GLsizei)batch.vertices.size();
+				if (count == 0) { continue; }
+
+				glLineWidth(batch.lineWidth);
+				if (batch.depthTest) glEnable(GL_DEPTH_TEST);
+				else glDisable(GL_DEPTH_TEST);
+
+				glDrawArrays(GL_LINES, first, count);
+
+				first += count;
+				batch.vertices.clear();
+			}
+
+			glBindVertexArray(0);
+
+		glUseProgram(0);
+
+		glLineWidth(1.0f);
+		if (wasDepthTest) glEnable(GL_DEPTH_TEST);
+		else glDisable(GL_DEPTH_TEST);
+	}
+};
\ No newline at end of file
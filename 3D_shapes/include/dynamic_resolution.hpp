@@ -0,0 +1,108 @@
+#pragma once
+
+#include "3d_shapes.h"
+
+#include <algorithm>
+#include <cmath>
+
+// picks the resolution the scene is rendered at from the gpu time of earlier frames, measured with timer queries
+// results are read a few frames late and never waited for, a frame without a free query is simply not measured
+class DynamicResolution {
+private:
+	static constexpr GLuint QUERY_COUNT = 4;
+
+	// weight of a new measurement, part of the target the scene may use and changes too small to act on
+	static constexpr GLdouble SMOOTHING = 0.25;
+	static constexpr GLdouble HEADROOM	= 0.9;
+	static constexpr GLfloat  DEADBAND	= 0.02f;
+
+	GLuint	queries[QUERY_COUNT];
+	GLfloat queryScales[QUERY_COUNT];	// scale each query was measured at
+	GLuint	issued;
+	GLuint	retired;
+
+	GLboolean measuring;
+
+	// gpu time grows with the pixel count, the square of the scale, so the cost of a full resolution frame
+	// is estimated from every measurement and the scale that fits the target follows from it
+	void Adjust(GLdouble ms, GLfloat measuredScale) {
+		GLdouble fullMs = ms / ((GLdouble)measuredScale * measuredScale);
+
+		gpuMs	   = ms;
+		fullSizeMs = (fullSizeMs <= 0.0) ? fullMs : fullSizeMs + SMOOTHING * (fullMs - fullSizeMs);
+
+		GLfloat ideal = std::clamp((GLfloat)std::sqrt(targetMs * HEADROOM / fullSizeMs), minScale, maxScale);
+
+		// the resolution would otherwise flicker between two neighbouring sizes
+		if (std::fabs(ideal - scale) < DEADBAND && ideal != minScale && ideal != maxScale) { return; }
+
+		scale = ideal;
+	}
+
+public:
+	GLdouble targetMs;
+	GLfloat	 minScale;
+	GLfloat	 maxScale;
+
+	GLfloat	 scale;
+	GLdouble gpuMs;			// last measured frame
+	GLdouble fullSizeMs;	// smoothed estimate at scale 1
+
+	DynamicResolution(GLdouble targetMs, GLfloat minScale = 0.5f, GLfloat maxScale = 1.0f) {
+		glGenQueries(QUERY_COUNT, queries);
+
+		this->targetMs = targetMs;
+		this->minScale = minScale;
+		this->maxScale = maxScale;
+
+		scale	   = maxScale;
+		gpuMs	   = 0.0;
+		fullSizeMs = 0.0;
+
+		issued	  = 0;
+		retired	  = 0;
+		measuring = GL_FALSE;
+	}
+
+	DynamicResolution(const DynamicResolution&) = delete;
+	DynamicResolution& operator=(const DynamicResolution&) = delete;
+
+	// size to render at for an output of size pixels
+	GLint Scaled(GLint size) const {
+		return std::max(1, (GLint)(size * scale + 0.5f));
+	}
+
+	// brackets the passes drawn at the scaled resolution
+	void Begin() {
+		measuring = (issued - retired < QUERY_COUNT);
+		if (!measuring) { return; }
+
+		queryScales[issued % QUERY_COUNT] = scale;
+		glBeginQuery(GL_TIME_ELAPSED, queries[issued % QUERY_COUNT]);
+	}
+
+	void End() {
+		if (measuring) {
+			glEndQuery(GL_TIME_ELAPSED);
+			issued++;
+		}
+
+		while (retired < issued) {
+			GLuint query = queries[retired % QUERY_COUNT];
+
+			GLint available = 0;
+			glGetQueryObjectiv(query, GL_QUERY_RESULT_AVAILABLE, &available);
+			if (!available) { break; }
+
+			GLuint64 nanoseconds = 0;
+			glGetQueryObjectui64v(query, GL_QUERY_RESULT, &nanoseconds);
+
+			Adjust(nanoseconds / 1e6, queryScales[retired % QUERY_COUNT]);
+			retired++;
+		}
+	}
+
+	~DynamicResolution() {
+		glDeleteQueries(QUERY_COUNT, queries);
+	}
+};
\ No newline at end of file
@@ -2,17 +2,19 @@
 
 #include "3d_shapes.h"
 #include "camera.hpp"
+#include "profiler.hpp"
+#include "gl_resource.hpp"
 
 class Empty {
 protected:
-	GLuint VAO;
-	GLuint VBO;
+	VertexArrayHandle VAO;
+	BufferHandle	  VBO;
 
 	void BindVertices() {
 		glBindVertexArray(VAO);
 
 		glBindBuffer(GL_ARRAY_BUFFER, VBO);
-		glBufferData(GL_ARRAY_BUFFER, sizeof(GLfloat) * 3 * vertCount, vertices, GL_STATIC_DRAW);
+		glBufferData(GL_ARRAY_BUFFER, sizeof(GLfloat) * 3 * vertCount, vertices.data(), GL_STATIC_DRAW);
 
 		glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, 3 * sizeof(GL_FLOAT), (void*)0);
 		glEnableVertexAttribArray(0);
@@ -24,18 +26,18 @@ public:
 	glm::vec3 position;
 	glm::vec3 rotation;
 
-	GLfloat* vertices;
+	std::vector <GLfloat> vertices;
 	GLfloat lineWidth;
 
 	GLuint vertCount;
 	GLuint shaderProgram;
 
 	Empty(GLuint vertCount, glm::vec3 position = glm::vec3(0.0f, 0.0f, 0.0f), GLfloat lineWidth = 1.0f) {
-		glGenVertexArrays(1, &VAO);
-		glGenBuffers(1, &VBO);
+		VAO = VertexArrayHandle::Create();
+		VBO = BufferHandle::Create();
 
 		this->vertCount = vertCount;
-		this->vertices  = new GLfloat[vertCount * 3];
+		this->vertices.resize(vertCount * 3);
 
 		this->position	= position;
 		this->rotation	= glm::vec3(0.0f, 0.0f, 0.0f);
@@ -58,6 +60,8 @@ public:
 	}
 
 	void SetMats(Camera camera) {
+		PROFILE_SCOPE("Empty::SetMats");
+
 		glUseProgram(shaderProgram);
 
 		GLuint proj_loc = glGetUniformLocation(shaderProgram, "projection");
@@ -72,6 +76,8 @@ public:
 	}
 
 	virtual void Draw(Camera camera) {
+		PROFILE_SCOPE("Empty::Draw");
+
 		SetMats(camera);
 
 		glLineWidth(lineWidth);
@@ -87,27 +93,14 @@ public:
 		glLineWidth(1.0f);
 	}
 
-	~Empty() {
-		delete[] vertices;
+	// the handles delete the vertex array and buffer
+	Empty(const Empty&) = delete;
+	Empty& operator=(const Empty&) = delete;
 
-		glDeleteBuffers(1, &VBO);
-		glDeleteVertexArrays(1, &VAO);
-	}
-};
+	Empty(Empty&&) = default;
+	Empty& operator=(Empty&&) = default;
 
-class Line : public Empty {
-public:
-	Line(glm::vec3 start, glm::vec3 end, GLfloat lineWidth = 1.0f) : Empty(2, 0.5f * (start + end), lineWidth) {
-		vertices[0] = start.x;
-		vertices[1] = start.y;
-		vertices[2] = start.z;
-
-		vertices[3] = end.x;
-		vertices[4] = end.y;
-		vertices[5] = end.z;
-
-		BindVertices();
-	}
+	virtual ~Empty() = default;
 };
 
 class Grid : public Empty {
@@ -0,0 +1,304 @@
+#pragma once
+
+#include "3d_shapes.h"
+#include "image_writer.hpp"
+
+#include <algorithm>
+#include <condition_variable>
+#include <cstdio>
+#include <deque>
+#include <filesystem>
+#include <iostream>
+#include <mutex>
+#include <string>
+#include <thread>
+
+// reads finished frames back through a ring of pixel buffer objects and encodes them on worker threads
+// glReadPixels into a PBO returns immediately, the buffer is only mapped once its fence has signalled
+class FrameCapture {
+private:
+	struct Readback {
+		GLuint	  PBO;
+		GLsizei	  size;
+		GLsync	  fence;
+
+		GLint		width, height;
+		GLboolean	hdr;
+		std::string path;
+	};
+
+	struct EncodeJob {
+		std::vector <unsigned char> pixels;		// rgba rows from the bottom row up, as read from gl
+
+		GLint		width, height;
+		GLboolean	hdr;
+		std::string path;
+	};
+
+	std::vector <Readback> ring;
+	GLuint next;		// slot the next readback goes to
+	GLuint pending;		// readbacks in flight, the oldest sits at next - pending
+
+	std::deque <EncodeJob>	  jobs;
+	std::vector <std::thread> workers;
+	std::mutex				  jobMutex;
+	std::condition_variable	  jobAdded;
+	std::condition_variable	  jobTaken;
+	GLboolean				  stopping;
+
+	static constexpr size_t MAX_QUEUED_JOBS = 8;
+
+	std::string screenshotPath;
+	std::string sequenceDirectory;
+	std::string sequenceExtension;
+	GLuint		sequenceFrame;
+
+	static void Encode(EncodeJob& job) {
+		size_t pixelCount = (size_t)job.width * job.height;
+		bool written;
+
+		// flip to top row first and drop alpha, blending leaves it below one where the grid is drawn
+		if (job.hdr) {
+			const GLfloat* rgba = (const GLfloat*)job.pixels.data();
+			std::vector <GLfloat> rgb(3 * pixelCount);
+
+			for (GLint y = 0; y < job.height; y++) {
+				const GLfloat* src = rgba + 4 * (size_t)(job.height - 1 - y) * job.width;
+				GLfloat* dst = &rgb[3 * (size_t)y * job.width];
+
+				for (GLint x = 0; x < job.width; x++) {
+					dst[3 * x]	   = src[4 * x];
+					dst[3 * x + 1] = src[4 * x + 1];
+					dst[3 * x + 2] = src[4 * x + 2];
+				}
+			}
+
+			written = ImageWriter::WriteEXR(job.path, job.width, job.height, rgb.data());
+		}
+		else {
+			std::vector <unsigned char> rgb(3 * pixelCount);
+
+			for (GLint y = 0; y < job.height; y++) {
+				const unsigned char* src = &job.pixels[4 * (size_t)(job.height - 1 - y) * job.width];
+				unsigned char* dst = &rgb[3 * (size_t)y * job.width];
+
+				for (GLint x = 0; x < job.width; x++) {
+					dst[3 * x]	   = src[4 * x];
+					dst[3 * x + 1] = src[4 * x + 1];
+					dst[3 * x + 2] = src[4 * x + 2];
+				}
+			}
+
+			written = ImageWriter::WritePNG(job.path, job.width, job.height, rgb.data());
+		}
+
+		if (!written) {
+			std::cout << "ERROR::FRAME_CAPTURE::CANNOT_WRITE_IMAGE\n";
+			std::cout << job.path << std::endl;
+		}
+	}
+
+	void WorkerLoop() {
+		while (true) {
+			EncodeJob job;
+
+			{
+				std::unique_lock <std::mutex> lock(jobMutex);
+				jobAdded.wait(lock, [this] { return stopping || !jobs.empty(); });
+
+				if (jobs.empty()) { return; }
+
+				job = std::move(jobs.front());
+				jobs.pop_front();
+			}
+
+			jobTaken.notify_all();
+			Encode(job);
+		}
+	}
+
+	// maps the oldest readback and hands its pixels to the encoders, wait chooses between blocking and polling
+	GLboolean Retire(GLboolean wait) {
+		if (pending == 0) { return GL_FALSE; }
+
+		Readback& readback = ring[(next + ring.size() - pending) % ring.size()];
+
+		GLenum status = glClientWaitSync(readback.fence, wait ? GL_SYNC_FLUSH_COMMANDS_BIT : 0, wait ? GL_TIMEOUT_IGNORED : 0);
+		if (status == GL_TIMEOUT_EXPIRED || status == GL_WAIT_FAILED) { return GL_FALSE; }
+
+		glDeleteSync(readback.fence);
+		readback.fence = nullptr;
+
+		EncodeJob job;
+		job.width  = readback.width;
+		job.height = readback.height;
+		job.hdr	   = readback.hdr;
+		job.path   = readback.path;
+
+		glBindBuffer(GL_PIXEL_PACK_BUFFER, readback.PBO);
+
+		const unsigned char* data = (const unsigned char*)glMapBufferRange(GL_PIXEL_PACK_BUFFER, 0, readback.size, GL_MAP_READ_BIT);
+		if (data != nullptr) {
+			job.pixels.assign(data, data + readback.size);
+			glUnmapBuffer(GL_PIXEL_PACK_BUFFER);
+		}
+
+		glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+		pending--;
+
+		if (job.pixels.empty()) { return GL_TRUE; }
+
+		{
+			// back pressure, if the encoders fall behind the render loop waits instead of queueing unbounded memory
+			std::unique_lock <std::mutex> lock(jobMutex);
+			jobTaken.wait(lock, [this] { return jobs.size() < MAX_QUEUED_JOBS; });
+
+			jobs.push_back(std::move(job));
+		}
+
+		jobAdded.notify_one();
+		return GL_TRUE;
+	}
+
+	static std::string Extension(const std::string& path) {
+		size_t dot = path.find_last_of('.');
+		return (dot == std::string::npos) ? "" : path.substr(dot + 1);
+	}
+
+public:
+	GLuint framesCaptured;
+
+	FrameCapture(GLuint ringSize = 3, GLuint encoderThreads = 0) {
+		ring.resize(ringSize > 0 ? ringSize : 1);
+
+		for (Readback& readback : ring) {
+			glGenBuffers(1, &readback.PBO);
+
+			readback.size  = 0;
+			readback.fence = nullptr;
+		}
+
+		next	 = 0;
+		pending	 = 0;
+		stopping = GL_FALSE;
+
+		sequenceFrame  = 0;
+		framesCaptured = 0;
+
+		if (encoderThreads == 0) encoderThreads = std::max(1u, std::thread::hardware_concurrency() / 2);
+
+		for (GLuint i = 0; i < encoderThreads; i++) {
+			workers.emplace_back(&FrameCapture::WorkerLoop, this);
+		}
+	}
+
+	FrameCapture(const FrameCapture&) = delete;
+	FrameCapture& operator=(const FrameCapture&) = delete;
+
+	// the next captured frame is written to path, .exr writes float data, anything else a png
+	// the frames come from GL_RGBA8 targets, so an exr holds the same 8 bit values as a png, without extra range or precision
+	void Screenshot(const std::string& path) {
+		screenshotPath = path;
+	}
+
+	// writes every following frame as directory/frame_000000.extension until StopSequence
+	void StartSequence(const std::string& directory, const std::string& extension = "png") {
+		std::error_code error;
+		std::filesystem::create_directories(directory, error);
+
+		sequenceDirectory = directory;
+		sequenceExtension = extension;
+		sequenceFrame	  = 0;
+	}
+
+	void StopSequence() {
+		sequenceDirectory.clear();
+	}
+
+	GLboolean Recording() const {
+		return !sequenceDirectory.empty();
+	}
+
+	GLboolean Active() const {
+		return Recording() || !screenshotPath.empty() || pending > 0;
+	}
+
+	// call after the frame is complete in framebuffer, before it is overwritten
+	void Capture(GLuint framebuffer, GLint width, GLint height) {
+		// pick up finished readbacks without waiting
+		while (Retire(GL_FALSE));
+
+		std::string path;
+
+		if (!screenshotPath.empty()) {
+			path = screenshotPath;
+			screenshotPath.clear();
+		}
+		else if (Recording()) {
+			char name[32];
+			std::snprintf(name, sizeof(name), "/frame_%06u.", sequenceFrame++);
+
+			path = sequenceDirectory + name + sequenceExtension;
+		}
+
+		if (path.empty()) { return; }
+
+		// every slot is still in flight, the oldest one has to finish first
+		if (pending == ring.size()) Retire(GL_TRUE);
+
+		Readback& readback = ring[next];
+		readback.hdr	= Extension(path) == "exr";
+		readback.width	= width;
+		readback.height = height;
+		readback.path	= path;
+
+		GLsizei size = width * height * (readback.hdr ? 4 * sizeof(GLfloat) : 4);
+
+		glBindBuffer(GL_PIXEL_PACK_BUFFER, readback.PBO);
+		if (size != readback.size) {
+			glBufferData(GL_PIXEL_PACK_BUFFER, size, nullptr, GL_STREAM_READ);
+			readback.size = size;
+		}
+
+		glBindFramebuffer(GL_READ_FRAMEBUFFER, framebuffer);
+		glPixelStorei(GL_PACK_ALIGNMENT, 4);
+		glReadPixels(0, 0, width, height, GL_RGBA, readback.hdr ? GL_FLOAT : GL_UNSIGNED_BYTE, (void*)0);
+		glBindFramebuffer(GL_READ_FRAMEBUFFER, 0);
+
+		glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+
+		readback.fence = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+
+		next = (next + 1) % ring.size();
+		pending++;
+		framesCaptured++;
+	}
+
+	// blocks until every readback has been handed to the encoders
+	void Flush() {
+		while (pending > 0 && Retire(GL_TRUE));
+	}
+
+	// needs the gl context, finishes outstanding readbacks and waits for the encoders
+	void Shutdown() {
+		Flush();
+
+		{
+			std::lock_guard <std::mutex> lock(jobMutex);
+			stopping = GL_TRUE;
+		}
+
+		jobAdded.notify_all();
+		for (std::thread& worker : workers) worker.join();
+		workers.clear();
+
+		for (Readback& readback : ring) {
+			if (readback.PBO != 0) glDeleteBuffers(1, &readback.PBO);
+			readback.PBO = 0;
+		}
+	}
+
+	~FrameCapture() {
+		if (!workers.empty()) Shutdown();
+	}
+};
\ No newline at end of file
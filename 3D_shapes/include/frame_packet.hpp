@@ -0,0 +1,65 @@
+#pragma once
+
+#include "3d_shapes.h"
+#include "camera.hpp"
+#include "mesh_object.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <vector>
+
+// a mesh to draw and where, the render thread copies model into the mesh before drawing it
+struct DrawItem {
+	MeshObject* mesh;
+	glm::mat4	model;
+};
+
+// everything one frame is drawn from, built by the update thread and left alone once it is published
+// the meshes it points to are only touched by the render thread while the loop runs
+struct FramePacket {
+	GLuint64 frame;
+
+	// when input and simulation were sampled, the latency of a frame is measured from here
+	std::chrono::steady_clock::time_point sampled;
+
+	GLint  width;
+	GLint  height;
+	Camera camera;
+
+	std::vector <DrawItem> draws;	// meshes inside the view frustum, or every mesh when the renderer culls itself
+	GLuint culled;
+
+	// one shot requests from the keyboard, carried out by the thread that owns the gl context
+	GLboolean screenshot;
+	GLboolean toggleRecording;
+	GLboolean toggleOverlay;
+	GLboolean dumpTrace;
+
+	FramePacket() {
+		frame  = 0;
+		width  = 0;
+		height = 0;
+		culled = 0;
+
+		screenshot = toggleRecording = toggleOverlay = dumpTrace = GL_FALSE;
+	}
+};
+
+// time from sampling a packet to having its frame submitted, swap included
+struct LatencyStats {
+	GLuint	 frames	 = 0;
+	GLdouble totalMs = 0.0;
+	GLdouble maxMs	 = 0.0;
+
+	void Add(const FramePacket& packet) {
+		GLdouble ms = std::chrono::duration<GLdouble, std::milli>(std::chrono::steady_clock::now() - packet.sampled).count();
+
+		frames++;
+		totalMs += ms;
+		maxMs	 = std::max(maxMs, ms);
+	}
+
+	GLdouble AverageMs() const {
+		return (frames > 0) ? totalMs / frames : 0.0;
+	}
+};
\ No newline at end of file
@@ -0,0 +1,120 @@
+#pragma once
+
+#include "3d_shapes.h"
+
+// drives the main loop: simulation advances in fixed steps, frames are paced by vsync or a cap,
+// and in on-demand mode the loop sleeps in glfwWaitEvents until something asks for a redraw
+class FrameScheduler {
+private:
+	GLdouble lastTime;
+	GLdouble lastFrame;
+	GLdouble accumulator;
+
+	GLboolean redraw;
+	GLboolean animating;
+
+public:
+	GLdouble  fixedStep;	// seconds of simulated time per update
+	GLdouble  frameCap;		// minimum seconds between two frames, 0 disables the cap
+	GLuint	  maxSteps;		// upper bound on catch-up updates after a stall
+	GLboolean onDemand;
+	GLboolean vsync;
+
+	FrameScheduler(GLdouble updateRate = 120.0, GLdouble maxFps = 0.0, GLboolean onDemand = GL_TRUE) {
+		this->fixedStep = 1.0 / updateRate;
+		this->frameCap	= (maxFps > 0.0) ? 1.0 / maxFps : 0.0;
+		this->maxSteps	= 8;
+		this->onDemand	= onDemand;
+		this->vsync		= GL_FALSE;
+
+		lastTime	= 0.0;
+		lastFrame	= 0.0;
+		accumulator = 0.0;
+
+		redraw	  = GL_TRUE;
+		animating = GL_FALSE;
+	}
+
+	// needs a current context, the swap interval is per context
+	void SetVsync(GLboolean enabled) {
+		vsync = enabled;
+		glfwSwapInterval(enabled ? 1 : 0);
+	}
+
+	void SetFrameCap(GLdouble maxFps) {
+		frameCap = (maxFps > 0.0) ? 1.0 / maxFps : 0.0;
+	}
+
+	// called by anything that changes what is on screen (input, resize, scene edits)
+	void RequestRedraw() {
+		redraw = GL_TRUE;
+	}
+
+	// keeps the loop running while an update is in progress, e.g. a held movement key
+	void SetAnimating(GLboolean active) {
+		animating = active;
+	}
+
+	GLboolean Idle() const {
+		return onDemand && !redraw && !animating;
+	}
+
+	void Start() {
+		lastTime  = glfwGetTime();
+		lastFrame = lastTime;
+	}
+
+	// pumps events, blocking while idle or until the frame cap allows the next frame
+	void WaitForEvents() {
+		if (Idle()) {
+			glfwWaitEvents();
+
+			// time spent asleep is not simulated
+			lastTime = glfwGetTime();
+			accumulator = 0.0;
+			return;
+		}
+
+		if (frameCap > 0.0) {
+			GLdouble remaining = lastFrame + frameCap - glfwGetTime();
+
+			if (remaining > 0.0) {
+				glfwWaitEventsTimeout(remaining);
+				return;
+			}
+		}
+
+		glfwPollEvents();
+	}
+
+	// returns the number of fixed updates to run before drawing this frame
+	GLuint Advance() {
+		GLdouble now = glfwGetTime();
+
+		accumulator += now - lastTime;
+		lastTime = now;
+
+		GLuint steps = (GLuint)(accumulator / fixedStep);
+
+		if (steps > maxSteps) {
+			steps = maxSteps;
+			accumulator = 0.0;
+		}
+		else {
+			accumulator -= steps * fixedStep;
+		}
+
+		return steps;
+	}
+
+	GLboolean ShouldDraw() const {
+		if (frameCap > 0.0 && glfwGetTime() - lastFrame < frameCap) return GL_FALSE;
+
+		return !Idle();
+	}
+
+	void EndFrame() {
+		lastFrame = glfwGetTime();
+		redraw = GL_FALSE;
+	}
+};
\ No newline at end of file
@@ -0,0 +1,42 @@
+#pragma once
+
+#include "3d_shapes.h"
+
+// world space planes of a view frustum as normal and distance, inside is positive
+struct Frustum {
+	glm::vec4 planes[6];
+
+	Frustum() {
+		for (glm::vec4& plane : planes) plane = glm::vec4(0.0f, 0.0f, 0.0f, 1.0f);
+	}
+
+	// Gribb and Hartmann, the planes are sums and differences of the rows of projection * view
+	explicit Frustum(const glm::mat4& viewProjection) {
+		glm::mat4 rows = glm::transpose(viewProjection);
+
+		for (GLuint i = 0; i < 3; i++) {
+			planes[2 * i]	  = rows[3] + rows[i];
+			planes[2 * i + 1] = rows[3] - rows[i];
+		}
+	}
+
+	// a box given as center and half extent, tested against each plane at the corner furthest inside
+	GLboolean Intersects(const glm::vec3& center, const glm::vec3& extent) const {
+		for (const glm::vec4& plane : planes) {
+			glm::vec3 normal(plane);
+
+			if (glm::dot(normal, center) + glm::dot(glm::abs(normal), extent) + plane.w < 0.0f) { return GL_FALSE; }
+		}
+
+		return GL_TRUE;
+	}
+
+	// the world space box around local bounds moved by model, as center and half extent
+	static void WorldBox(const glm::mat4& model, const glm::vec3& boundsMin, const glm::vec3& boundsMax, glm::vec3& center, glm::vec3& extent) {
+		glm::vec3 localCenter = 0.5f * (boundsMin + boundsMax);
+		glm::vec3 localExtent = 0.5f * (boundsMax - boundsMin);
+
+		center = glm::vec3(model * glm::vec4(localCenter, 1.0f));
+		extent = glm::abs(glm::vec3(model[0])) * localExtent.x + glm::abs(glm::vec3(model[1])) * localExtent.y + glm::abs(glm::vec3(model[2])) * localExtent.z;
+	}
+};
\ No newline at end of file
@@ -0,0 +1,182 @@
+#pragma once
+
+#include "3d_shapes.h"
+
+#include <utility>
+#include <vector>
+
+// how each kind of gl object is created and deleted, used by GLHandle
+struct BufferTraits {
+	static GLuint Create() { GLuint name = 0; glGenBuffers(1, &name); return name; }
+	static void Delete(GLuint name) { glDeleteBuffers(1, &name); }
+};
+
+struct VertexArrayTraits {
+	static GLuint Create() { GLuint name = 0; glGenVertexArrays(1, &name); return name; }
+	static void Delete(GLuint name) { glDeleteVertexArrays(1, &name); }
+};
+
+struct ProgramTraits {
+	static GLuint Create() { return glCreateProgram(); }
+	static void Delete(GLuint name) { glDeleteProgram(name); }
+};
+
+// owns one gl object name and deletes it when destroyed, can be moved but not copied
+// converts to GLuint so it can be passed straight to gl calls
+template <typename Traits>
+class GLHandle {
+private:
+	GLuint name;
+
+public:
+	GLHandle() : name(0) {}
+	explicit GLHandle(GLuint name) : name(name) {}
+
+	GLHandle(const GLHandle&) = delete;
+	GLHandle& operator=(const GLHandle&) = delete;
+
+	GLHandle(GLHandle&& other) noexcept : name(other.name) {
+		other.name = 0;
+	}
+
+	GLHandle& operator=(GLHandle&& other) noexcept {
+		if (this != &other) {
+			Reset();
+			std::swap(name, other.name);
+		}
+
+		return *this;
+	}
+
+	static GLHandle Create() {
+		return GLHandle(Traits::Create());
+	}
+
+	// gives up ownership without deleting
+	GLuint Release() {
+		GLuint released = name;
+		name = 0;
+
+		return released;
+	}
+
+	void Reset(GLuint replacement = 0) {
+		if (name != 0) Traits::Delete(name);
+		name = replacement;
+	}
+
+	operator GLuint() const {
+		return name;
+	}
+
+	~GLHandle() {
+		Reset();
+	}
+};
+
+typedef GLHandle <BufferTraits>		 BufferHandle;
+typedef GLHandle <VertexArrayTraits> VertexArrayHandle;
+typedef GLHandle <ProgramTraits>	 ProgramHandle;
+
+// keeps buffers and vertex arrays of destroyed meshes around for the next ones, so rebuilding or swapping
+// meshes at runtime skips glGen*, glDelete* and the driver allocation behind glBufferData
+// buffers are grouped in size classes a quarter power of two apart, at most a fifth of a buffer goes unused
+class GLResourcePool {
+private:
+	static constexpr GLsizeiptr MIN_BUFFER_SIZE = 256;
+	static constexpr size_t		MAX_FREE_PER_CLASS = 8;
+
+	inline static std::vector <std::vector <GLuint>> freeBuffers;
+	inline static std::vector <GLuint>				 freeVertexArrays;
+
+	static GLsizeiptr ClassCapacity(GLuint sizeClass) {
+		return (MIN_BUFFER_SIZE / 4) * (4 + sizeClass % 4) << (sizeClass / 4);
+	}
+
+	static GLuint SizeClass(GLsizeiptr size) {
+		GLuint sizeClass = 0;
+		while (ClassCapacity(sizeClass) < size) sizeClass++;
+
+		return sizeClass;
+	}
+
+public:
+	// acquisitions served from the pool and ones that had to create a new object
+	inline static GLuint hits	= 0;
+	inline static GLuint misses = 0;
+
+	// the capacity AcquireBuffer gives a buffer of size bytes, buffers made elsewhere and released into the pool
+	// have to be allocated with it
+	static GLsizeiptr Capacity(GLsizeiptr size) {
+		return ClassCapacity(SizeClass(size));
+	}
+
+	// a buffer with room for at least size bytes, capacity is set to its actual size
+	// the contents are undefined, fill it with glBufferSubData
+	static BufferHandle AcquireBuffer(GLsizeiptr size, GLsizeiptr& capacity) {
+		GLuint sizeClass = SizeClass(size);
+		capacity = ClassCapacity(sizeClass);
+
+		if (sizeClass < freeBuffers.size() && !freeBuffers[sizeClass].empty()) {
+			GLuint name = freeBuffers[sizeClass].back();
+			freeBuffers[sizeClass].pop_back();
+
+			hits++;
+			return BufferHandle(name);
+		}
+
+		misses++;
+		BufferHandle buffer = BufferHandle::Create();
+
+		// the copy target leaves the array and element bindings of the current vertex array alone
+		glBindBuffer(GL_COPY_WRITE_BUFFER, buffer);
+		glBufferData(GL_COPY_WRITE_BUFFER, capacity, nullptr, GL_STATIC_DRAW);
+		glBindBuffer(GL_COPY_WRITE_BUFFER, 0);
+
+		return buffer;
+	}
+
+	// capacity as returned by AcquireBuffer, full size classes delete the buffer instead
+	static void ReleaseBuffer(BufferHandle&& buffer, GLsizeiptr capacity) {
+		if (buffer == 0) { return; }
+
+		GLuint sizeClass = SizeClass(capacity);
+		if (sizeClass >= freeBuffers.size()) freeBuffers.resize(sizeClass + 1);
+
+		if (freeBuffers[sizeClass].size() < MAX_FREE_PER_CLASS) freeBuffers[sizeClass].push_back(buffer.Release());
+		else buffer.Reset();
+	}
+
+	// recycled vertex arrays keep their old attribute state, the new owner has to set every attribute it uses
+	// and disable the ones it does not
+	static VertexArrayHandle AcquireVertexArray() {
+		if (!freeVertexArrays.empty()) {
+			GLuint name = freeVertexArrays.back();
+			freeVertexArrays.pop_back();
+
+			hits++;
+			return VertexArrayHandle(name);
+		}
+
+		misses++;
+		return VertexArrayHandle::Create();
+	}
+
+	static void ReleaseVertexArray(VertexArrayHandle&& vertexArray) {
+		if (vertexArray == 0) { return; }
+
+		if (freeVertexArrays.size() < MAX_FREE_PER_CLASS * 4) freeVertexArrays.push_back(vertexArray.Release());
+		else vertexArray.Reset();
+	}
+
+	// needs the gl context, deletes everything the pool holds
+	static void Clear() {
+		for (std::vector <GLuint>& buffers : freeBuffers) {
+			if (!buffers.empty()) glDeleteBuffers((GLsizei)buffers.size(), buffers.data());
+			buffers.clear();
+		}
+
+		if (!freeVertexArrays.empty()) glDeleteVertexArrays((GLsizei)freeVertexArrays.size(), freeVertexArrays.data());
+		freeVertexArrays.clear();
+	}
+};
\ No newline at end of file
@@ -0,0 +1,208 @@
+#pragma once
+
+#include <cstdint>
+#include <cstring>
+#include <fstream>
+#include <string>
+#include <vector>
+
+// dependency free image encoders for captured frames, pixels are rgb rows from the top row down
+class ImageWriter {
+private:
+	struct CrcTable {
+		uint32_t entries[256];
+
+		CrcTable() {
+			for (uint32_t i = 0; i < 256; i++) {
+				uint32_t c = i;
+				for (int k = 0; k < 8; k++) c = (c & 1) ? 0xEDB88320u ^ (c >> 1) : c >> 1;
+				entries[i] = c;
+			}
+		}
+	};
+
+	static uint32_t Crc32(const unsigned char* data, size_t size, uint32_t crc = 0) {
+		// function local statics are initialized once even with several encoder threads
+		static const CrcTable crcTable;
+		const uint32_t* table = crcTable.entries;
+
+		crc = ~crc;
+		for (size_t i = 0; i < size; i++) crc = table[(crc ^ data[i]) & 0xFF] ^ (crc >> 8);
+
+		return ~crc;
+	}
+
+	static void PutBigEndian(std::vector <unsigned char>& out, uint32_t value) {
+		out.push_back((unsigned char)(value >> 24));
+		out.push_back((unsigned char)(value >> 16));
+		out.push_back((unsigned char)(value >> 8));
+		out.push_back((unsigned char)value);
+	}
+
+	template <typename T>
+	static void PutLittleEndian(std::vector <unsigned char>& out, T value) {
+		unsigned char bytes[sizeof(T)];
+		std::memcpy(bytes, &value, sizeof(T));
+
+		out.insert(out.end(), bytes, bytes + sizeof(T));
+	}
+
+	static void PutString(std::vector <unsigned char>& out, const char* text) {
+		out.insert(out.end(), text, text + std::strlen(text) + 1);
+	}
+
+	static void PngChunk(std::vector <unsigned char>& out, const char* type, const std::vector <unsigned char>& data) {
+		PutBigEndian(out, (uint32_t)data.size());
+
+		size_t start = out.size();
+		out.insert(out.end(), type, type + 4);
+		out.insert(out.end(), data.begin(), data.end());
+
+		PutBigEndian(out, Crc32(&out[start], out.size() - start));
+	}
+
+	static bool WriteFile(const std::string& path, const std::vector <unsigned char>& data) {
+		std::ofstream file(path, std::ios::binary | std::ios::trunc);
+		if (!file.is_open()) { return false; }
+
+		file.write((const char*)data.data(), data.size());
+		return file.good();
+	}
+
+public:
+	// 8 bit rgb png, the zlib stream uses stored deflate blocks so encoding is a plain copy
+	static bool WritePNG(const std::string& path, uint32_t width, uint32_t height, const unsigned char* rgb) {
+		std::vector <unsigned char> png = { 0x89, 'P', 'N', 'G', '\r', '\n', 0x1A, '\n' };
+
+		std::vector <unsigned char> header;
+		PutBigEndian(header, width);
+		PutBigEndian(header, height);
+		header.insert(header.end(), { 8, 2, 0, 0, 0 });		// bit depth, rgb, deflate, no filter, no interlace
+
+		PngChunk(png, "IHDR", header);
+
+		// every row is prefixed with filter type 0
+		size_t rowBytes = 3 * (size_t)width;
+		std::vector <unsigned char> raw;
+		raw.reserve((rowBytes + 1) * height);
+
+		for (uint32_t y = 0; y < height; y++) {
+			raw.push_back(0);
+			raw.insert(raw.end(), rgb + y * rowBytes, rgb + (y + 1) * rowBytes);
+		}
+
+		std::vector <unsigned char> zlib = { 0x78, 0x01 };
+		zlib.reserve(raw.size() + raw.size() / 65535 * 5 + 16);
+
+		uint32_t a = 1, b = 0;
+		for (size_t offset = 0; offset < raw.size() || offset == 0; offset += 65535) {
+			size_t size = (raw.size() - offset < 65535) ? raw.size() - offset : 65535;
+			bool last = offset + size == raw.size();
+
+			zlib.push_back(last ? 1 : 0);
+			zlib.push_back((unsigned char)size);
+			zlib.push_back((unsigned char)(size >> 8));
+			zlib.push_back((unsigned char)~size);
+			zlib.push_back((unsigned char)(~size >> 8));
+			zlib.insert(zlib.end(), raw.begin() + offset, raw.begin() + offset + size);
+
+			for (size_t i = offset; i < offset + size; i++) {
+				a = (a + raw[i]) % 65521;
+				b = (b + a) % 65521;
+			}
+
+			if (last) break;
+		}
+
+		PutBigEndian(zlib, (b << 16) | a);
+
+		PngChunk(png, "IDAT", zlib);
+		PngChunk(png, "IEND", {});
+
+		return WriteFile(path, png);
+	}
+
+	// uncompressed scanline OpenEXR with 32 bit float R, G and B channels
+	static bool WriteEXR(const std::string& path, uint32_t width, uint32_t height, const float* rgb) {
+		std::vector <unsigned char> exr;
+
+		PutLittleEndian<uint32_t>(exr, 20000630);	// magic
+		PutLittleEndian<uint32_t>(exr, 2);			// version 2, single part scanline
+
+		// channels are stored in alphabetical order
+		PutString(exr, "channels");
+		PutString(exr, "chlist");
+		PutLittleEndian<uint32_t>(exr, 3 * 18 + 1);
+
+		for (const char* channel : { "B", "G", "R" }) {
+			PutString(exr, channel);
+			PutLittleEndian<int32_t>(exr, 2);		// FLOAT
+			PutLittleEndian<uint32_t>(exr, 0);		// pLinear and reserved
+			PutLittleEndian<int32_t>(exr, 1);		// x sampling
+			PutLittleEndian<int32_t>(exr, 1);		// y sampling
+		}
+		exr.push_back(0);
+
+		PutString(exr, "compression");
+		PutString(exr, "compression");
+		PutLittleEndian<uint32_t>(exr, 1);
+		exr.push_back(0);							// NO_COMPRESSION
+
+		for (const char* window : { "dataWindow", "displayWindow" }) {
+			PutString(exr, window);
+			PutString(exr, "box2i");
+			PutLittleEndian<uint32_t>(exr, 16);
+			PutLittleEndian<int32_t>(exr, 0);
+			PutLittleEndian<int32_t>(exr, 0);
+			PutLittleEndian<int32_t>(exr, (int32_t)width - 1);
+			PutLittleEndian<int32_t>(exr, (int32_t)height - 1);
+		}
+
+		PutString(exr, "lineOrder");
+		PutString(exr, "lineOrder");
+		PutLittleEndian<uint32_t>(exr, 1);
+		exr.push_back(0);							// INCREASING_Y
+
+		PutString(exr, "pixelAspectRatio");
+		PutString(exr, "float");
+		PutLittleEndian<uint32_t>(exr, 4);
+		PutLittleEndian<float>(exr, 1.0f);
+
+		PutString(exr, "screenWindowCenter");
+		PutString(exr, "v2f");
+		PutLittleEndian<uint32_t>(exr, 8);
+		PutLittleEndian<float>(exr, 0.0f);
+		PutLittleEndian<float>(exr, 0.0f);
+
+		PutString(exr, "screenWindowWidth");
+		PutString(exr, "float");
+		PutLittleEndian<uint32_t>(exr, 4);
+		PutLittleEndian<float>(exr, 1.0f);
+
+		exr.push_back(0);
+
+		// offset table, one block per scanline without compression
+		uint32_t lineBytes = 3 * width * sizeof(float);
+		uint64_t offset = exr.size() + 8 * (uint64_t)height;
+
+		for (uint32_t y = 0; y < height; y++) {
+			PutLittleEndian<uint64_t>(exr, offset);
+			offset += 8 + lineBytes;
+		}
+
+		exr.reserve(exr.size() + (size_t)height * (8 + lineBytes));
+
+		for (uint32_t y = 0; y < height; y++) {
+			PutLittleEndian<int32_t>(exr, (int32_t)y);
+			PutLittleEndian<uint32_t>(exr, lineBytes);
+
+			const float* row = rgb + 3 * (size_t)y * width;
+
+			for (int channel = 2; channel >= 0; channel--) {
+				for (uint32_t x = 0; x < width; x++) PutLittleEndian<float>(exr, row[3 * x + channel]);
+			}
+		}
+
+		return WriteFile(path, exr);
+	}
+};
\ No newline at end of file
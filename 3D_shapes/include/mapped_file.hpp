@@ -0,0 +1,140 @@
+#pragma once
+
+#include <cstddef>
+
+#ifdef _WIN32
+#ifndef WIN32_LEAN_AND_MEAN
+#define WIN32_LEAN_AND_MEAN
+#endif
+#ifndef NOMINMAX
+#define NOMINMAX
+#endif
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+// read only memory mapping of a whole file, move only
+class MappedFile {
+private:
+	const unsigned char* mapping;
+	size_t fileSize;
+
+#ifdef _WIN32
+	HANDLE file;
+	HANDLE fileMapping;
+#endif
+
+public:
+	MappedFile() {
+		mapping	 = nullptr;
+		fileSize = 0;
+
+#ifdef _WIN32
+		file		= INVALID_HANDLE_VALUE;
+		fileMapping = nullptr;
+#endif
+	}
+
+	MappedFile(const MappedFile&) = delete;
+	MappedFile& operator=(const MappedFile&) = delete;
+
+	MappedFile(MappedFile&& other) noexcept : MappedFile() {
+		*this = static_cast<MappedFile&&>(other);
+	}
+
+	MappedFile& operator=(MappedFile&& other) noexcept {
+		if (this != &other) {
+			Close();
+
+			mapping	 = other.mapping;
+			fileSize = other.fileSize;
+			other.mapping  = nullptr;
+			other.fileSize = 0;
+
+#ifdef _WIN32
+			file		= other.file;
+			fileMapping = other.fileMapping;
+			other.file		  = INVALID_HANDLE_VALUE;
+			other.fileMapping = nullptr;
+#endif
+		}
+
+		return *this;
+	}
+
+	~MappedFile() {
+		Close();
+	}
+
+	// returns false if the file does not exist, is empty or cannot be mapped
+	bool Open(const char* path) {
+		Close();
+
+#ifdef _WIN32
+		file = CreateFileA(path, GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_FLAG_SEQUENTIAL_SCAN, nullptr);
+		if (file == INVALID_HANDLE_VALUE) { return false; }
+
+		LARGE_INTEGER size;
+		if (!GetFileSizeEx(file, &size) || size.QuadPart == 0) { Close(); return false; }
+
+		fileMapping = CreateFileMappingA(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+		if (fileMapping == nullptr) { Close(); return false; }
+
+		mapping = (const unsigned char*)MapViewOfFile(fileMapping, FILE_MAP_READ, 0, 0, 0);
+		if (mapping == nullptr) { Close(); return false; }
+
+		fileSize = (size_t)size.QuadPart;
+#else
+		int fd = open(path, O_RDONLY);
+		if (fd == -1) { return false; }
+
+		struct stat info;
+		if (fstat(fd, &info) != 0 || info.st_size == 0) { close(fd); return false; }
+
+		void* view = mmap(nullptr, (size_t)info.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+		close(fd);
+
+		if (view == MAP_FAILED) { return false; }
+
+		// the whole file is read front to back, let the kernel read ahead
+		madvise(view, (size_t)info.st_size, MADV_SEQUENTIAL);
+
+		mapping	 = (const unsigned char*)view;
+		fileSize = (size_t)info.st_size;
+#endif
+
+		return true;
+	}
+
+	void Close() {
+#ifdef _WIN32
+		if (mapping != nullptr) UnmapViewOfFile(mapping);
+		if (fileMapping != nullptr) CloseHandle(fileMapping);
+		if (file != INVALID_HANDLE_VALUE) CloseHandle(file);
+
+		fileMapping = nullptr;
+		file		= INVALID_HANDLE_VALUE;
+#else
+		if (mapping != nullptr) munmap((void*)mapping, fileSize);
+#endif
+
+		mapping	 = nullptr;
+		fileSize = 0;
+	}
+
+	bool IsOpen() const {
+		return mapping != nullptr;
+	}
+
+	const unsigned char* Data() const {
+		return mapping;
+	}
+
+	size_t Size() const {
+		return fileSize;
+	}
+};
\ No newline at end of file
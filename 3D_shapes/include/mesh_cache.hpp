@@ -0,0 +1,229 @@
+#pragma once
+
+#include "3d_shapes.h"
+#include "mapped_file.hpp"
+
+#include <atomic>
+#include <cstdio>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <string>
+#include <thread>
+
+// bump whenever a generator changes its output, old cache files are then ignored and rewritten
+// Load also rejects files whose counts differ from what the mesh expects, in case a bump is forgotten
+constexpr GLuint MESH_CACHE_VERSION = 3;
+
+// blobs in a cache file start on this boundary so the mapping can be handed to the driver as is
+constexpr GLuint MESH_CACHE_ALIGNMENT = 64;
+
+// identifies a generated mesh by its shape type and every parameter that affects the output
+class MeshCacheKey {
+private:
+	void Mix(const void* data, size_t size) {
+		const unsigned char* bytes = (const unsigned char*)data;
+
+		// 64 bit FNV-1a
+		for (size_t i = 0; i < size; i++) {
+			hash ^= bytes[i];
+			hash *= 0x100000001B3ull;
+		}
+	}
+
+public:
+	std::string type;
+	GLuint64	hash;
+
+	MeshCacheKey(const char* type) {
+		this->type = type;
+		this->hash = 0xCBF29CE484222325ull;
+
+		Mix(type, std::strlen(type));
+	}
+
+	MeshCacheKey& operator<<(GLfloat value) { Mix(&value, sizeof(value)); return *this; }
+	MeshCacheKey& operator<<(GLuint value) { Mix(&value, sizeof(value)); return *this; }
+	MeshCacheKey& operator<<(glm::vec3 value) { return *this << value.x << value.y << value.z; }
+};
+
+// one vertex attribute, interleaved at offset bytes into each vertex
+struct MeshCacheAttrib {
+	GLuint location;
+	GLuint components;
+	GLuint type;
+	GLuint offset;
+};
+
+struct MeshCacheHeader {
+	char	 magic[4];
+	GLuint	 version;
+	GLuint64 key;
+
+	GLuint vertCount;
+	GLuint triCount;
+	GLuint stride;
+	GLuint layoutCount;
+	MeshCacheAttrib layout[4];
+
+	GLfloat boundsMin[3];
+	GLfloat boundsMax[3];
+
+	// byte offsets from the start of the file
+	GLuint64 vertexOffset;
+	GLuint64 vertexBytes;
+	GLuint64 indexOffset;
+	GLuint64 indexBytes;
+};
+
+// a validated cache file, the pointers stay valid as long as the mapping is open
+struct CachedMesh {
+	MappedFile file;
+	const MeshCacheHeader* header = nullptr;
+
+	const GLfloat* vertices = nullptr;
+	const GLuint*  indices	= nullptr;
+};
+
+class MeshCache {
+private:
+	// the layout MeshObject::BindBuffers sets up: position at location 0, normal at location 1
+	static GLuint DescribeLayout(GLuint attribCount, MeshCacheAttrib* layout) {
+		layout[0] = { 0, 3, GL_FLOAT, 0 };
+		if (attribCount != 6) { return 1; }
+
+		layout[1] = { 1, 3, GL_FLOAT, 3 * sizeof(GLfloat) };
+		return 2;
+	}
+
+	static GLuint64 Align(GLuint64 offset) {
+		return (offset + MESH_CACHE_ALIGNMENT - 1) / MESH_CACHE_ALIGNMENT * MESH_CACHE_ALIGNMENT;
+	}
+
+public:
+	inline static std::string directory = "./cache";
+	inline static GLboolean	  enabled	= GL_TRUE;
+
+	// meshes may be built on several threads at once
+	inline static std::atomic <GLuint> hits	  = 0;
+	inline static std::atomic <GLuint> misses = 0;
+
+	static std::string PathFor(const MeshCacheKey& key) {
+		char name[32];
+		std::snprintf(name, sizeof(name), "_%016llx.mesh", (unsigned long long)key.hash);
+
+		return directory + "/" + key.type + name;
+	}
+
+	// maps the cache file for key, fails if it is missing, stale or does not match the expected counts and layout
+	static bool Load(const MeshCacheKey& key, GLuint vertCount, GLuint triCount, GLuint attribCount, CachedMesh& mesh) {
+		if (!enabled) { return false; }
+
+		if (!mesh.file.Open(PathFor(key).c_str()) || mesh.file.Size() < sizeof(MeshCacheHeader)) {
+			mesh.file.Close();
+			misses++;
+			return false;
+		}
+
+		const MeshCacheHeader* header = (const MeshCacheHeader*)mesh.file.Data();
+
+		MeshCacheAttrib layout[4];
+		GLuint layoutCount = DescribeLayout(attribCount, layout);
+
+		bool valid = std::memcmp(header->magic, "MESH", 4) == 0
+			&& header->version	   == MESH_CACHE_VERSION
+			&& header->key		   == key.hash
+			&& header->vertCount   == vertCount
+			&& header->triCount	   == triCount
+			&& header->stride	   == attribCount * sizeof(GLfloat)
+			&& header->layoutCount == layoutCount
+			&& std::memcmp(header->layout, layout, layoutCount * sizeof(MeshCacheAttrib)) == 0
+			&& header->vertexBytes == (GLuint64)header->vertCount * header->stride
+			&& header->indexBytes  == (GLuint64)header->triCount * 3 * sizeof(GLuint)
+			&& header->vertexOffset % MESH_CACHE_ALIGNMENT == 0
+			&& header->indexOffset % MESH_CACHE_ALIGNMENT == 0
+			&& header->vertexBytes <= mesh.file.Size() && header->vertexOffset <= mesh.file.Size() - header->vertexBytes
+			&& header->indexBytes <= mesh.file.Size() && header->indexOffset <= mesh.file.Size() - header->indexBytes;
+
+		if (!valid) {
+			mesh.file.Close();
+			misses++;
+			return false;
+		}
+
+		mesh.header	  = header;
+		mesh.vertices = (const GLfloat*)(mesh.file.Data() + header->vertexOffset);
+		mesh.indices  = (const GLuint*)(mesh.file.Data() + header->indexOffset);
+
+		hits++;
+		return true;
+	}
+
+	static bool Store(const MeshCacheKey& key, GLuint vertCount, GLuint triCount, GLuint attribCount,
+		const GLfloat* vertices, const GLuint* indices, glm::vec3 boundsMin, glm::vec3 boundsMax) {
+		if (!enabled) { return false; }
+
+		MeshCacheHeader header;
+		std::memset(&header, 0, sizeof(header));
+		std::memcpy(header.magic, "MESH", 4);
+
+		header.version	   = MESH_CACHE_VERSION;
+		header.key		   = key.hash;
+		header.vertCount   = vertCount;
+		header.triCount	   = triCount;
+		header.stride	   = attribCount * sizeof(GLfloat);
+		header.layoutCount = DescribeLayout(attribCount, header.layout);
+
+		for (GLuint i = 0; i < 3; i++) {
+			header.boundsMin[i] = boundsMin[i];
+			header.boundsMax[i] = boundsMax[i];
+		}
+
+		header.vertexOffset = Align(sizeof(MeshCacheHeader));
+		header.vertexBytes	= (GLuint64)vertCount * header.stride;
+		header.indexOffset	= Align(header.vertexOffset + header.vertexBytes);
+		header.indexBytes	= (GLuint64)triCount * 3 * sizeof(GLuint);
+
+		std::error_code error;
+		std::filesystem::create_directories(directory, error);
+
+		// write next to the target and rename, so a reader never maps a half written file
+		// the temporary name is per thread, two threads may store the same key
+		std::string path = PathFor(key);
+		std::string temp = path + "." + std::to_string(std::hash <std::thread::id>()(std::this_thread::get_id())) + ".tmp";
+
+		{
+			std::ofstream file(temp, std::ios::binary | std::ios::trunc);
+
+			if (!file.is_open()) {
+				std::cout << "ERROR::MESH_CACHE::CANNOT_WRITE\n";
+				std::cout << temp << std::endl;
+
+				return false;
+			}
+
+			const char padding[MESH_CACHE_ALIGNMENT] = {};
+
+			file.write((const char*)&header, sizeof(header));
+			file.write(padding, header.vertexOffset - sizeof(header));
+			file.write((const char*)vertices, header.vertexBytes);
+			file.write(padding, header.indexOffset - header.vertexOffset - header.vertexBytes);
+			file.write((const char*)indices, header.indexBytes);
+
+			if (!file.good()) {
+				file.close();
+				std::filesystem::remove(temp, error);
+				return false;
+			}
+		}
+
+		std::filesystem::rename(temp, path, error);
+		if (error) {
+			std::filesystem::remove(temp, error);
+			return false;
+		}
+
+		return true;
+	}
+};
\ No newline at end of file
@@ -0,0 +1,975 @@
+#pragma once
+
+#include "3d_shapes.h"
+#include "mapped_file.hpp"
+#include "mesh_object.hpp"
+
+#include <algorithm>
+#include <cctype>
+#include <charconv>
+#include <cstdint>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <unordered_map>
+
+// vertices are position and normal interleaved, the layout MeshObject::BindBuffers expects
+struct MeshData {
+	std::vector <GLfloat> vertices;
+	std::vector <GLuint>  indices;
+
+	GLboolean hasNormals = GL_FALSE;
+};
+
+// just enough json for the glTF scene description of a .glb file
+struct JsonValue {
+	enum class Type { null, boolean, number, string, array, object };
+
+	Type		type	= Type::null;
+	GLdouble	number	= 0.0;
+	std::string string;
+
+	std::vector <JsonValue> array;
+	std::vector <std::pair <std::string, JsonValue>> object;
+
+	const JsonValue* Get(const char* key) const {
+		for (const std::pair <std::string, JsonValue>& member : object) {
+			if (member.first == key) return &member.second;
+		}
+
+		return nullptr;
+	}
+
+	GLdouble Number(const char* key, GLdouble fallback = 0.0) const {
+		const JsonValue* value = Get(key);
+		return (value != nullptr && value->type == Type::number) ? value->number : fallback;
+	}
+
+	// Number as a count, offset or index, fails for negative, fractional, nan or anything past 2^53
+	// where doubles stop holding every integer, so the conversion to size_t is always defined
+	bool Index(const char* key, size_t& index, GLdouble fallback = 0.0) const {
+		GLdouble value = Number(key, fallback);
+		if (!(value >= 0.0 && value < 9007199254740992.0) || value != (GLdouble)(uint64_t)value) { return false; }
+
+		index = (size_t)value;
+		return true;
+	}
+
+	static const char* SkipSpaces(const char* p, const char* end) {
+		while (p < end && (*p == ' ' || *p == '\t' || *p == '\n' || *p == '\r')) p++;
+		return p;
+	}
+
+	// returns nullptr on malformed input
+	static const char* Parse(const char* p, const char* end, JsonValue& value, GLuint depth = 0) {
+		p = SkipSpaces(p, end);
+		if (p == end || depth > 64) { return nullptr; }
+
+		if (*p == '{') {
+			value.type = Type::object;
+			p = SkipSpaces(p + 1, end);
+
+			if (p < end && *p == '}') { return p + 1; }
+
+			while (p < end) {
+				JsonValue key;
+				p = Parse(p, end, key, depth + 1);
+				if (p == nullptr || key.type != Type::string) { return nullptr; }
+
+				p = SkipSpaces(p, end);
+				if (p == end || *p != ':') { return nullptr; }
+
+				value.object.emplace_back(key.string, JsonValue());
+				p = Parse(p + 1, end, value.object.back().second, depth + 1);
+				if (p == nullptr) { return nullptr; }
+
+				p = SkipSpaces(p, end);
+				if (p < end && *p == ',') { p++; continue; }
+				if (p < end && *p == '}') { return p + 1; }
+
+				return nullptr;
+			}
+
+			return nullptr;
+		}
+
+		if (*p == '[') {
+			value.type = Type::array;
+			p = SkipSpaces(p + 1, end);
+
+			if (p < end && *p == ']') { return p + 1; }
+
+			while (p < end) {
+				value.array.emplace_back();
+				p = Parse(p, end, value.array.back(), depth + 1);
+				if (p == nullptr) { return nullptr; }
+
+				p = SkipSpaces(p, end);
+				if (p < end && *p == ',') { p++; continue; }
+				if (p < end && *p == ']') { return p + 1; }
+
+				return nullptr;
+			}
+
+			return nullptr;
+		}
+
+		if (*p == '"') {
+			value.type = Type::string;
+
+			for (p++; p < end && *p != '"'; p++) {
+				// escapes are kept verbatim, glTF keys and the fields read here never need them
+				if (*p == '\\' && p + 1 < end) value.string += *p++;
+				value.string += *p;
+			}
+
+			return (p < end) ? p + 1 : nullptr;
+		}
+
+		if (end - p >= 4 && std::strncmp(p, "true", 4) == 0) { value.type = Type::boolean; value.number = 1.0; return p + 4; }
+		if (end - p >= 5 && std::strncmp(p, "false", 5) == 0) { value.type = Type::boolean; return p + 5; }
+		if (end - p >= 4 && std::strncmp(p, "null", 4) == 0) { return p + 4; }
+
+		value.type = Type::number;
+		std::from_chars_result result = std::from_chars(p, end, value.number);
+
+		return (result.ec == std::errc()) ? result.ptr : nullptr;
+	}
+};
+
+class MeshImporter {
+private:
+	struct ObjCorner {
+		GLint64 position;
+		GLint64 normal;		// -1 when the face has no normal
+	};
+
+	// a slice of the file ending on a line break, parsed by one thread
+	struct ObjChunk {
+		const char* begin;
+		const char* end;
+
+		size_t positions, normals, triangles;			// counted in the first pass
+		size_t positionBase, normalBase, triangleBase;	// where this chunk writes in the second pass
+
+		GLboolean valid;
+	};
+
+	static const char* SkipSpaces(const char* p, const char* end) {
+		while (p < end && (*p == ' ' || *p == '\t')) p++;
+		return p;
+	}
+
+	static const char* NextLine(const char* p, const char* end) {
+		const char* eol = (const char*)std::memchr(p, '\n', end - p);
+		return (eol == nullptr) ? end : eol + 1;
+	}
+
+	static const char* ParseFloat(const char* p, const char* end, GLfloat& value) {
+		p = SkipSpaces(p, end);
+		if (p < end && *p == '+') p++;
+
+		std::from_chars_result result = std::from_chars(p, end, value);
+		if (result.ec != std::errc()) value = 0.0f;
+
+		return result.ptr;
+	}
+
+	// one "v", "v/vt", "v//vn" or "v/vt/vn" token, indices are returned as written in the file
+	static const char* ParseCorner(const char* p, const char* end, GLint64& position, GLint64& normal) {
+		position = 0;
+		normal	 = 0;
+
+		std::from_chars_result result = std::from_chars(p, end, position);
+		p = result.ptr;
+
+		if (p < end && *p == '/') {
+			p++;
+
+			GLint64 texture = 0;
+			if (p < end && *p != '/') p = std::from_chars(p, end, texture).ptr;
+
+			if (p < end && *p == '/') p = std::from_chars(p + 1, end, normal).ptr;
+		}
+
+		while (p < end && *p != ' ' && *p != '\t' && *p != '\r' && *p != '\n') p++;
+		return p;
+	}
+
+	static void CountObjChunk(ObjChunk& chunk) {
+		chunk.positions = chunk.normals = chunk.triangles = 0;
+
+		for (const char* line = chunk.begin; line < chunk.end; line = NextLine(line, chunk.end)) {
+			const char* p = SkipSpaces(line, chunk.end);
+			if (chunk.end - p < 2) continue;
+
+			if (p[0] == 'v' && (p[1] == ' ' || p[1] == '\t')) chunk.positions++;
+			else if (p[0] == 'v' && p[1] == 'n') chunk.normals++;
+			else if (p[0] == 'f' && (p[1] == ' ' || p[1] == '\t')) {
+				size_t corners = 0;
+				const char* eol = NextLine(p, chunk.end);
+
+				for (p = SkipSpaces(p + 1, eol); p < eol && *p != '\r' && *p != '\n'; p = SkipSpaces(p, eol)) {
+					while (p < eol && *p != ' ' && *p != '\t' && *p != '\r' && *p != '\n') p++;
+					corners++;
+				}
+
+				if (corners >= 3) chunk.triangles += corners - 2;
+			}
+		}
+	}
+
+	// second pass, writes straight to this chunk's slots in the shared arrays
+	static void ParseObjChunk(ObjChunk& chunk, GLfloat* positions, GLfloat* normals, ObjCorner* corners) {
+		size_t position = chunk.positionBase;
+		size_t normal	= chunk.normalBase;
+		size_t triangle = chunk.triangleBase;
+
+		chunk.valid = GL_TRUE;
+
+		for (const char* line = chunk.begin; line < chunk.end; line = NextLine(line, chunk.end)) {
+			const char* p = SkipSpaces(line, chunk.end);
+			const char* eol = NextLine(p, chunk.end);
+			if (eol - p < 2) continue;
+
+			if (p[0] == 'v' && (p[1] == ' ' || p[1] == '\t')) {
+				p = ParseFloat(p + 2, eol, positions[3 * position]);
+				p = ParseFloat(p, eol, positions[3 * position + 1]);
+				ParseFloat(p, eol, positions[3 * position + 2]);
+				position++;
+			}
+			else if (p[0] == 'v' && p[1] == 'n') {
+				p = ParseFloat(p + 2, eol, normals[3 * normal]);
+				p = ParseFloat(p, eol, normals[3 * normal + 1]);
+				ParseFloat(p, eol, normals[3 * normal + 2]);
+				normal++;
+			}
+			else if (p[0] == 'f' && (p[1] == ' ' || p[1] == '\t')) {
+				ObjCorner first = {}, previous = {};
+				GLuint count = 0;
+
+				for (p = SkipSpaces(p + 1, eol); p < eol && *p != '\r' && *p != '\n'; p = SkipSpaces(p, eol)) {
+					GLint64 v, n;
+					p = ParseCorner(p, eol, v, n);
+
+					// negative indices count back from the last element defined so far
+					ObjCorner corner;
+					corner.position = (v > 0) ? v - 1 : (GLint64)position + v;
+					corner.normal	= (n > 0) ? n - 1 : (n < 0 ? (GLint64)normal + n : -1);
+
+					if (v == 0 || corner.position < 0) chunk.valid = GL_FALSE;
+
+					// polygons are triangulated as a fan around the first corner
+					if (count == 0) first = corner;
+					else if (count >= 2) {
+						corners[3 * triangle]	  = first;
+						corners[3 * triangle + 1] = previous;
+						corners[3 * triangle + 2] = corner;
+						triangle++;
+					}
+
+					previous = corner;
+					count++;
+				}
+			}
+		}
+	}
+
+	// merges vertices with identical position and normal in place, the write position never passes the read position
+	static void Weld(MeshData& mesh) {
+		struct Key {
+			GLfloat values[6];
+
+			bool operator==(const Key& other) const { return std::memcmp(values, other.values, sizeof(values)) == 0; }
+		};
+
+		struct KeyHash {
+			size_t operator()(const Key& key) const {
+				GLuint64 hash = 0xCBF29CE484222325ull;
+				const unsigned char* bytes = (const unsigned char*)key.values;
+
+				for (size_t i = 0; i < sizeof(key.values); i++) {
+					hash ^= bytes[i];
+					hash *= 0x100000001B3ull;
+				}
+
+				return (size_t)hash;
+			}
+		};
+
+		size_t vertCount = mesh.vertices.size() / 6;
+
+		std::unordered_map <Key, GLuint, KeyHash> unique;
+		unique.reserve(vertCount);
+
+		std::vector <GLuint> remap(vertCount);
+		GLuint written = 0;
+
+		for (size_t i = 0; i < vertCount; i++) {
+			Key key;
+			std::memcpy(key.values, &mesh.vertices[6 * i], sizeof(key.values));
+
+			// without normals only the position matters, so seams get smooth normals later
+			if (!mesh.hasNormals) key.values[3] = key.values[4] = key.values[5] = 0.0f;
+
+			std::pair <std::unordered_map <Key, GLuint, KeyHash>::iterator, bool> result = unique.emplace(key, written);
+
+			if (result.second) {
+				if (written != i) std::memmove(&mesh.vertices[6 * written], &mesh.vertices[6 * i], 6 * sizeof(GLfloat));
+				written++;
+			}
+
+			remap[i] = result.first->second;
+		}
+
+		mesh.vertices.resize(6 * (size_t)written);
+
+		for (GLuint& index : mesh.indices) index = remap[index];
+	}
+
+	static GLuint ThreadCount(size_t bytes) {
+		GLuint threads = std::max(1u, std::thread::hardware_concurrency());
+
+		// below a few MB the threads cost more than they save
+		return (GLuint)std::min<size_t>(threads, std::max<size_t>(1, bytes / (4 << 20)));
+	}
+
+	// runs work(i) for i in [0, count) spread across the available cores
+	template <typename Function>
+	static void ParallelFor(GLuint count, Function work) {
+		std::vector <std::thread> threads;
+
+		for (GLuint i = 1; i < count; i++) threads.emplace_back(work, i);
+		if (count > 0) work(0);
+
+		for (std::thread& thread : threads) thread.join();
+	}
+
+	static GLuint PlySize(const std::string& type) {
+		if (type == "char" || type == "uchar" || type == "int8" || type == "uint8") return 1;
+		if (type == "short" || type == "ushort" || type == "int16" || type == "uint16") return 2;
+		if (type == "int" || type == "uint" || type == "float" || type == "int32" || type == "uint32" || type == "float32") return 4;
+		if (type == "double" || type == "float64") return 8;
+
+		return 0;
+	}
+
+	static GLdouble PlyRead(const unsigned char* data, const std::string& type, GLboolean swap) {
+		unsigned char bytes[8];
+		GLuint size = PlySize(type);
+
+		for (GLuint i = 0; i < size; i++) bytes[i] = swap ? data[size - 1 - i] : data[i];
+
+		if (type == "char" || type == "int8")		{ int8_t v;   std::memcpy(&v, bytes, 1); return v; }
+		if (type == "uchar" || type == "uint8")		{ uint8_t v;  std::memcpy(&v, bytes, 1); return v; }
+		if (type == "short" || type == "int16")		{ int16_t v;  std::memcpy(&v, bytes, 2); return v; }
+		if (type == "ushort" || type == "uint16")	{ uint16_t v; std::memcpy(&v, bytes, 2); return v; }
+		if (type == "int" || type == "int32")		{ int32_t v;  std::memcpy(&v, bytes, 4); return v; }
+		if (type == "uint" || type == "uint32")		{ uint32_t v; std::memcpy(&v, bytes, 4); return v; }
+		if (type == "float" || type == "float32")	{ float v;	  std::memcpy(&v, bytes, 4); return v; }
+
+		double v;
+		std::memcpy(&v, bytes, 8);
+		return v;
+	}
+
+	static GLboolean HostIsLittleEndian() {
+		GLuint one = 1;
+		return *(unsigned char*)&one == 1;
+	}
+
+public:
+	// picks the parser from the file extension
+	static bool Load(const char* path, MeshData& mesh) {
+		MappedFile file;
+
+		if (!file.Open(path)) {
+			std::cout << "ERROR::MESH_IMPORT::CANNOT_OPEN_FILE\n";
+			std::cout << path << std::endl;
+
+			return false;
+		}
+
+		std::string extension(path);
+		extension = extension.substr(extension.find_last_of('.') + 1);
+		std::transform(extension.begin(), extension.end(), extension.begin(), [](char c) { return (char)std::tolower((unsigned char)c); });
+
+		bool loaded = false;
+
+		if (extension == "obj") loaded = LoadOBJ(file, mesh);
+		else if (extension == "ply") loaded = LoadPLY(file, mesh);
+		else if (extension == "glb") loaded = LoadGLB(file, mesh);
+		else {
+			std::cout << "ERROR::MESH_IMPORT::UNSUPPORTED_FORMAT\n";
+			std::cout << path << std::endl;
+
+			return false;
+		}
+
+		if (!loaded) {
+			std::cout << "ERROR::MESH_IMPORT::MALFORMED_FILE\n";
+			std::cout << path << std::endl;
+		}
+
+		return loaded;
+	}
+
+	static bool LoadOBJ(const MappedFile& file, MeshData& mesh) {
+		const char* data = (const char*)file.Data();
+		const char* end	 = data + file.Size();
+
+		// split on line breaks, then count elements per chunk so every chunk knows where to write
+		std::vector <ObjChunk> chunks(ThreadCount(file.Size()));
+
+		for (size_t i = 0; i < chunks.size(); i++) {
+			chunks[i].begin = (i == 0) ? data : chunks[i - 1].end;
+			chunks[i].end	= (i + 1 == chunks.size()) ? end : NextLine(std::max(chunks[i].begin, data + file.Size() * (i + 1) / chunks.size()), end);
+		}
+
+		ParallelFor((GLuint)chunks.size(), [&](GLuint i) { CountObjChunk(chunks[i]); });
+
+		size_t positionCount = 0, normalCount = 0, triangleCount = 0;
+
+		for (ObjChunk& chunk : chunks) {
+			chunk.positionBase = positionCount;
+			chunk.normalBase   = normalCount;
+			chunk.triangleBase = triangleCount;
+
+			positionCount += chunk.positions;
+			normalCount	  += chunk.normals;
+			triangleCount += chunk.triangles;
+		}
+
+		if (positionCount == 0 || triangleCount == 0) { return false; }
+
+		std::vector <GLfloat>	positions(3 * positionCount);
+		std::vector <GLfloat>	normals(3 * normalCount);
+		std::vector <ObjCorner> corners(3 * triangleCount);
+
+		ParallelFor((GLuint)chunks.size(), [&](GLuint i) { ParseObjChunk(chunks[i], positions.data(), normals.data(), corners.data()); });
+
+		mesh.hasNormals = normalCount > 0;
+
+		for (const ObjChunk& chunk : chunks) {
+			if (!chunk.valid) { return false; }
+		}
+
+		for (const ObjCorner& corner : corners) {
+			if (corner.position >= (GLint64)positionCount || corner.normal >= (GLint64)normalCount) { return false; }
+			if (corner.normal < 0) mesh.hasNormals = GL_FALSE;
+		}
+
+		// each distinct position/normal pair becomes one vertex
+		std::unordered_map <GLuint64, GLuint> unique;
+		unique.reserve(positionCount);
+
+		mesh.vertices.clear();
+		mesh.vertices.reserve(6 * positionCount);
+		mesh.indices.resize(corners.size());
+
+		for (size_t i = 0; i < corners.size(); i++) {
+			GLuint64 normal = mesh.hasNormals ? (GLuint64)corners[i].normal : 0;
+			GLuint64 key	= (GLuint64)corners[i].position << 32 | normal;
+
+			std::pair <std::unordered_map <GLuint64, GLuint>::iterator, bool> result = unique.emplace(key, (GLuint)(mesh.vertices.size() / 6));
+
+			if (result.second) {
+				const GLfloat* p = &positions[3 * corners[i].position];
+				const GLfloat* n = mesh.hasNormals ? &normals[3 * corners[i].normal] : nullptr;
+
+				mesh.vertices.insert(mesh.vertices.end(), { p[0], p[1], p[2], n ? n[0] : 0.0f, n ? n[1] : 0.0f, n ? n[2] : 0.0f });
+			}
+
+			mesh.indices[i] = result.first->second;
+		}
+
+		if (!mesh.hasNormals) ComputeNormals(mesh);
+
+		return true;
+	}
+
+	// binary little or big endian ply with a vertex and a face element, extra properties are skipped
+	static bool LoadPLY(const MappedFile& file, MeshData& mesh) {
+		const char* data = (const char*)file.Data();
+		const char* end	 = data + file.Size();
+
+		const char* headerEnd = nullptr;
+		for (const char* line = data; line < end; line = NextLine(line, end)) {
+			if (std::strncmp(line, "end_header", 10) == 0) {
+				headerEnd = NextLine(line, end);
+				break;
+			}
+		}
+
+		if (headerEnd == nullptr || std::strncmp(data, "ply", 3) != 0) { return false; }
+
+		struct Property {
+			std::string name, type, countType;	// countType is only set for list properties
+			GLuint offset;
+		};
+
+		struct Element {
+			std::string name;
+			size_t count;
+			std::vector <Property> properties;
+
+			GLuint	  stride;	// only meaningful without list properties
+			GLboolean hasList;
+		};
+
+		std::vector <Element> elements;
+		GLboolean bigEndian = GL_FALSE;
+
+		std::istringstream header(std::string(data, headerEnd));
+		std::string line;
+
+		while (std::getline(header, line)) {
+			std::istringstream words(line);
+			std::string keyword;
+			words >> keyword;
+
+			if (keyword == "format") {
+				std::string format;
+				words >> format;
+
+				if (format == "ascii") { return false; }
+				bigEndian = format == "binary_big_endian";
+			}
+			else if (keyword == "element") {
+				Element element;
+				words >> element.name >> element.count;
+				element.stride	= 0;
+				element.hasList = GL_FALSE;
+
+				elements.push_back(element);
+			}
+			else if (keyword == "property" && !elements.empty()) {
+				Element& element = elements.back();
+				Property property;
+				words >> property.type;
+
+				if (property.type == "list") words >> property.countType >> property.type;
+				words >> property.name;
+
+				if (PlySize(property.type) == 0 || (!property.countType.empty() && PlySize(property.countType) == 0)) { return false; }
+
+				property.offset = element.stride;
+
+				if (property.countType.empty()) element.stride += PlySize(property.type);
+				else element.hasList = GL_TRUE;
+
+				element.properties.push_back(property);
+			}
+		}
+
+		GLboolean swap = bigEndian == HostIsLittleEndian();
+		const unsigned char* p = (const unsigned char*)headerEnd;
+		const unsigned char* fileEnd = (const unsigned char*)end;
+
+		mesh.vertices.clear();
+		mesh.indices.clear();
+
+		for (const Element& element : elements) {
+			if (element.name == "vertex") {
+				if (element.hasList || p + element.count * element.stride > fileEnd) { return false; }
+
+				const Property* fields[6] = {};
+				const char* names[6] = { "x", "y", "z", "nx", "ny", "nz" };
+
+				for (const Property& property : element.properties) {
+					for (GLuint i = 0; i < 6; i++) {
+						if (property.name == names[i]) fields[i] = &property;
+					}
+				}
+
+				if (!fields[0] || !fields[1] || !fields[2]) { return false; }
+				mesh.hasNormals = fields[3] && fields[4] && fields[5];
+
+				// vertices have a fixed stride, so ranges of them convert independently
+				mesh.vertices.resize(6 * element.count);
+
+				const unsigned char* base = p;
+				GLuint threads = ThreadCount(element.count * element.stride);
+
+				ParallelFor(threads, [&](GLuint t) {
+					size_t first = element.count * t / threads;
+					size_t last	 = element.count * (t + 1) / threads;
+
+					for (size_t v = first; v < last; v++) {
+						const unsigned char* vertex = base + v * element.stride;
+
+						for (GLuint i = 0; i < 6; i++) {
+							mesh.vertices[6 * v + i] = fields[i] ? (GLfloat)PlyRead(vertex + fields[i]->offset, fields[i]->type, swap) : 0.0f;
+						}
+					}
+				});
+
+				p += element.count * element.stride;
+			}
+			else if (element.name == "face") {
+				mesh.indices.reserve(3 * element.count);
+
+				for (size_t f = 0; f < element.count; f++) {
+					for (const Property& property : element.properties) {
+						GLuint size = PlySize(property.type);
+
+						if (property.countType.empty()) {
+							p += size;
+							continue;
+						}
+
+						GLuint countSize = PlySize(property.countType);
+						if (p + countSize > fileEnd) { return false; }
+
+						size_t corners = (size_t)PlyRead(p, property.countType, swap);
+						p += countSize;
+
+						if (p + corners * size > fileEnd) { return false; }
+
+						if (property.name == "vertex_indices" || property.name == "vertex_index") {
+							GLuint first = (GLuint)PlyRead(p, property.type, swap);
+
+							for (size_t c = 2; c < corners; c++) {
+								mesh.indices.push_back(first);
+								mesh.indices.push_back((GLuint)PlyRead(p + (c - 1) * size, property.type, swap));
+								mesh.indices.push_back((GLuint)PlyRead(p + c * size, property.type, swap));
+							}
+						}
+
+						p += corners * size;
+					}
+				}
+			}
+			else {
+				// unknown fixed size elements can be skipped, list elements can not
+				if (element.hasList && element.count > 0) { break; }
+				p += element.count * element.stride;
+			}
+		}
+
+		size_t vertCount = mesh.vertices.size() / 6;
+		if (vertCount == 0 || mesh.indices.empty()) { return false; }
+
+		for (GLuint index : mesh.indices) {
+			if (index >= vertCount) { return false; }
+		}
+
+		Weld(mesh);
+		if (!mesh.hasNormals) ComputeNormals(mesh);
+
+		return true;
+	}
+
+	// binary glTF 2.0, every triangle primitive of every mesh is merged, node transforms are not applied
+	static bool LoadGLB(const MappedFile& file, MeshData& mesh) {
+		const unsigned char* data = file.Data();
+		size_t size = file.Size();
+
+		GLuint header[5];
+		if (size < sizeof(header)) { return false; }
+		std::memcpy(header, data, sizeof(header));
+
+		// magic "glTF", version 2, then the json chunk
+		if (header[0] != 0x46546C67 || header[1] != 2 || header[4] != 0x4E4F534A || 20 + (size_t)header[3] > size) { return false; }
+
+		const char* json = (const char*)data + 20;
+		JsonValue root;
+		if (JsonValue::Parse(json, json + header[3], root) == nullptr) { return false; }
+
+		// the optional binary chunk follows the json chunk
+		const unsigned char* bin = nullptr;
+		size_t binSize = 0;
+		size_t binChunk = 20 + (size_t)header[3];
+
+		if (binChunk + 8 <= size) {
+			GLuint chunk[2];
+			std::memcpy(chunk, data + binChunk, sizeof(chunk));
+
+			if (chunk[1] == 0x004E4942 && binChunk + 8 + (size_t)chunk[0] <= size) {
+				bin = data + binChunk + 8;
+				binSize = chunk[0];
+			}
+		}
+
+		const JsonValue* meshes		 = root.Get("meshes");
+		const JsonValue* accessors	 = root.Get("accessors");
+		const JsonValue* bufferViews = root.Get("bufferViews");
+
+		if (!meshes || !accessors || !bufferViews || bin == nullptr) { return false; }
+
+		// resolves an accessor to a pointer into the binary chunk, its element count, stride and layout
+		// every element has to lie inside the buffer view and the view inside the binary chunk
+		auto resolve = [&](size_t index, const unsigned char*& first, size_t& count, size_t& stride, GLuint& componentType, GLuint& components) -> bool {
+			if (index >= accessors->array.size()) { return false; }
+			const JsonValue& accessor = accessors->array[index];
+
+			size_t typeNumber = 0;
+			if (!accessor.Index("componentType", typeNumber)) { return false; }
+
+			// GL_BYTE up to GL_FLOAT, without GL_INT which gltf does not allow
+			if (typeNumber < GL_BYTE || typeNumber > GL_FLOAT || typeNumber == GL_INT) { return false; }
+			componentType = (GLuint)typeNumber;
+
+			GLuint componentSize = (componentType == GL_BYTE || componentType == GL_UNSIGNED_BYTE) ? 1
+				: (componentType == GL_SHORT || componentType == GL_UNSIGNED_SHORT) ? 2 : 4;
+
+			const JsonValue* type = accessor.Get("type");
+			components = 0;
+
+			if (type != nullptr && type->string == "SCALAR") components = 1;
+			if (type != nullptr && type->string.size() == 4 && type->string.compare(0, 3, "VEC") == 0 && type->string[3] >= '2' && type->string[3] <= '4') components = type->string[3] - '0';
+
+			// matrices and anything unknown
+			if (components == 0) { return false; }
+
+			size_t elementSize = (size_t)componentSize * components;
+
+			if (accessor.Get("bufferView") == nullptr) { return false; }
+
+			size_t viewIndex;
+			if (!accessor.Index("bufferView", viewIndex) || viewIndex >= bufferViews->array.size()) { return false; }
+			const JsonValue& view = bufferViews->array[viewIndex];
+
+			// external buffers are not supported, only the embedded one
+			size_t buffer;
+			if (!view.Index("buffer", buffer) || buffer != 0) { return false; }
+
+			size_t viewOffset, viewLength, accessorOffset;
+
+			if (!accessor.Index("count", count) || !view.Index("byteStride", stride)) { return false; }
+			if (!view.Index("byteOffset", viewOffset) || !view.Index("byteLength", viewLength) || !accessor.Index("byteOffset", accessorOffset)) { return false; }
+
+			if (stride == 0) stride = elementSize;
+
+			// Index keeps every value below 2^53, and the checks below are subtractions of checked values,
+			// so nothing in the json can make them wrap around
+			if (viewLength > binSize || viewOffset > binSize - viewLength) { return false; }
+
+			if (count > 0) {
+				if (elementSize > viewLength || accessorOffset > viewLength - elementSize) { return false; }
+				if (count - 1 > (viewLength - elementSize - accessorOffset) / stride) { return false; }
+			}
+
+			first = bin + viewOffset + accessorOffset;
+			return true;
+		};
+
+		mesh.vertices.clear();
+		mesh.indices.clear();
+		mesh.hasNormals = GL_TRUE;
+
+		for (const JsonValue& gltfMesh : meshes->array) {
+			const JsonValue* primitives = gltfMesh.Get("primitives");
+			if (!primitives) continue;
+
+			for (const JsonValue& primitive : primitives->array) {
+				if (primitive.Number("mode", 4.0) != 4.0) continue;
+
+				const JsonValue* attributes = primitive.Get("attributes");
+				if (!attributes || !attributes->Get("POSITION")) continue;
+
+				const unsigned char* positions;
+				size_t vertCount, positionStride, accessor;
+				GLuint componentType, components;
+
+				// positions and normals are copied as three floats each
+				if (!attributes->Index("POSITION", accessor) || !resolve(accessor, positions, vertCount, positionStride, componentType, components) || componentType != GL_FLOAT || components != 3) { return false; }
+
+				const unsigned char* normals = nullptr;
+				size_t normalCount = 0, normalStride = 0;
+
+				if (attributes->Get("NORMAL")) {
+					if (!attributes->Index("NORMAL", accessor) || !resolve(accessor, normals, normalCount, normalStride, componentType, components) || componentType != GL_FLOAT || components != 3 || normalCount != vertCount) { return false; }
+				}
+				else mesh.hasNormals = GL_FALSE;
+
+				GLuint baseVertex = (GLuint)(mesh.vertices.size() / 6);
+				mesh.vertices.resize(mesh.vertices.size() + 6 * vertCount);
+
+				GLfloat* out = &mesh.vertices[6 * (size_t)baseVertex];
+				for (size_t v = 0; v < vertCount; v++) {
+					std::memcpy(out + 6 * v, positions + v * positionStride, 3 * sizeof(GLfloat));
+
+					if (normals) std::memcpy(out + 6 * v + 3, normals + v * normalStride, 3 * sizeof(GLfloat));
+					else out[6 * v + 3] = out[6 * v + 4] = out[6 * v + 5] = 0.0f;
+				}
+
+				if (primitive.Get("indices")) {
+					const unsigned char* indices;
+					size_t indexCount, indexStride;
+
+					if (!primitive.Index("indices", accessor) || !resolve(accessor, indices, indexCount, indexStride, componentType, components) || components != 1) { return false; }
+					if (componentType != GL_UNSIGNED_BYTE && componentType != GL_UNSIGNED_SHORT && componentType != GL_UNSIGNED_INT) { return false; }
+
+					GLuint indexSize = (componentType == GL_UNSIGNED_BYTE) ? 1 : (componentType == GL_UNSIGNED_SHORT ? 2 : 4);
+
+					for (size_t i = 0; i < indexCount - indexCount % 3; i++) {
+						GLuint index = 0;
+						std::memcpy(&index, indices + i * indexStride, indexSize);
+
+						if (index >= vertCount) { return false; }
+						mesh.indices.push_back(baseVertex + index);
+					}
+				}
+				else {
+					for (size_t i = 0; i < vertCount - vertCount % 3; i++) mesh.indices.push_back(baseVertex + (GLuint)i);
+				}
+			}
+		}
+
+		if (mesh.vertices.empty() || mesh.indices.empty()) { return false; }
+
+		Weld(mesh);
+		if (!mesh.hasNormals) ComputeNormals(mesh);
+
+		return true;
+	}
+
+	// area weighted vertex normals from the triangles
+	static void ComputeNormals(MeshData& mesh) {
+		size_t vertCount = mesh.vertices.size() / 6;
+
+		for (size_t i = 0; i < vertCount; i++) {
+			mesh.vertices[6 * i + 3] = mesh.vertices[6 * i + 4] = mesh.vertices[6 * i + 5] = 0.0f;
+		}
+
+		for (size_t i = 0; i + 2 < mesh.indices.size(); i += 3) {
+			GLfloat* a = &mesh.vertices[6 * (size_t)mesh.indices[i]];
+			GLfloat* b = &mesh.vertices[6 * (size_t)mesh.indices[i + 1]];
+			GLfloat* c = &mesh.vertices[6 * (size_t)mesh.indices[i + 2]];
+
+			// the cross product length is twice the area, so larger faces weigh more
+			glm::vec3 normal = glm::cross(glm::make_vec3(b) - glm::make_vec3(a), glm::make_vec3(c) - glm::make_vec3(a));
+
+			for (GLfloat* vertex : { a, b, c }) {
+				vertex[3] += normal.x;
+				vertex[4] += normal.y;
+				vertex[5] += normal.z;
+			}
+		}
+
+		for (size_t i = 0; i < vertCount; i++) {
+			glm::vec3 normal = glm::make_vec3(&mesh.vertices[6 * i + 3]);
+			GLfloat length = glm::length(normal);
+
+			normal = (length > 0.0f) ? normal / length : glm::vec3(0.0f, 0.0f, 1.0f);
+
+			mesh.vertices[6 * i + 3] = normal.x;
+			mesh.vertices[6 * i + 4] = normal.y;
+			mesh.vertices[6 * i + 5] = normal.z;
+		}
+
+		mesh.hasNormals = GL_TRUE;
+	}
+
+	// straightforward ifstream and stringstream obj reader, the baseline the streaming parser is measured against
+	static bool LoadOBJNaive(const char* path, MeshData& mesh) {
+		std::ifstream file(path);
+		if (!file.is_open()) { return false; }
+
+		std::vector <glm::vec3> positions, normals;
+		std::vector <std::pair <GLint64, GLint64>> corners;
+		std::unordered_map <GLuint64, GLuint> unique;
+
+		std::string line;
+		while (std::getline(file, line)) {
+			std::istringstream words(line);
+			std::string keyword;
+			words >> keyword;
+
+			if (keyword == "v") {
+				glm::vec3 p;
+				words >> p.x >> p.y >> p.z;
+				positions.push_back(p);
+			}
+			else if (keyword == "vn") {
+				glm::vec3 n;
+				words >> n.x >> n.y >> n.z;
+				normals.push_back(n);
+			}
+			else if (keyword == "f") {
+				std::vector <std::pair <GLint64, GLint64>> face;
+				std::string token;
+
+				while (words >> token) {
+					GLint64 v = 0, n = 0;
+					ParseCorner(token.data(), token.data() + token.size(), v, n);
+
+					face.emplace_back((v > 0) ? v - 1 : (GLint64)positions.size() + v, (n > 0) ? n - 1 : (n < 0 ? (GLint64)normals.size() + n : -1));
+				}
+
+				for (size_t i = 2; i < face.size(); i++) {
+					corners.push_back(face[0]);
+					corners.push_back(face[i - 1]);
+					corners.push_back(face[i]);
+				}
+			}
+		}
+
+		mesh.hasNormals = !normals.empty();
+		for (const std::pair <GLint64, GLint64>& corner : corners) {
+			if (corner.first < 0 || corner.first >= (GLint64)positions.size() || corner.second >= (GLint64)normals.size()) { return false; }
+			if (corner.second < 0) mesh.hasNormals = GL_FALSE;
+		}
+
+		mesh.vertices.clear();
+		mesh.indices.clear();
+
+		for (const std::pair <GLint64, GLint64>& corner : corners) {
+			GLuint64 key = (GLuint64)corner.first << 32 | (mesh.hasNormals ? (GLuint64)corner.second : 0);
+			std::pair <std::unordered_map <GLuint64, GLuint>::iterator, bool> result = unique.emplace(key, (GLuint)(mesh.vertices.size() / 6));
+
+			if (result.second) {
+				glm::vec3 p = positions[corner.first];
+				glm::vec3 n = mesh.hasNormals ? normals[corner.second] : glm::vec3(0.0f, 0.0f, 0.0f);
+
+				mesh.vertices.insert(mesh.vertices.end(), { p.x, p.y, p.z, n.x, n.y, n.z });
+			}
+
+			mesh.indices.push_back(result.first->second);
+		}
+
+		if (!mesh.hasNormals) ComputeNormals(mesh);
+
+		return !mesh.indices.empty();
+	}
+};
+
+// a mesh read from an .obj, binary .ply or .glb file, uploaded straight from the importer's buffers
+class ImportedMesh : public MeshObject {
+public:
+	std::string path;
+	GLboolean	loaded;
+
+	ImportedMesh(const char* path, glm::vec3 position = glm::vec3(0.0f, 0.0f, 0.0f)) : MeshObject(0, 0, 6) {
+		this->path	   = path;
+		this->position = position;
+		this->loaded   = GL_FALSE;
+
+		MeshData mesh;
+		if (!MeshImporter::Load(path, mesh)) { return; }
+
+		vertCount = (GLuint)(mesh.vertices.size() / 6);
+		triCount  = (GLuint)(mesh.indices.size() / 3);
+
+		// like the generated shapes, the position is baked into the vertices
+		boundsMin = boundsMax = glm::make_vec3(&mesh.vertices[0]) + position;
+
+		for (GLuint i = 0; i < vertCount; i++) {
+			GLfloat* vertex = &mesh.vertices[6 * (size_t)i];
+
+			vertex[0] += position.x;
+			vertex[1] += position.y;
+			vertex[2] += position.z;
+
+			boundsMin = glm::min(boundsMin, glm::make_vec3(vertex));
+			boundsMax = glm::max(boundsMax, glm::make_vec3(vertex));
+		}
+
+		UploadBuffers(mesh.vertices.data(), mesh.indices.data());
+		loaded = GL_TRUE;
+	}
+};
\ No newline at end of file
@@ -0,0 +1,330 @@
+#pragma once
+
+#include "3d_shapes.h"
+#include "gl_resource.hpp"
+#include "mesh_object.hpp"
+
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <iostream>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+// one mesh on its way from a worker thread to the gpu, shared by the loader and the handles to it
+struct MeshLoadJob {
+	enum Stage : GLuint { LOADING, READY, FAILED };
+
+	std::function <MeshObject*()> create;	// runs on a worker thread, where MeshObject::cpuOnly is set
+	std::unique_ptr <MeshObject>  mesh;
+
+	// filled on the loader context, handed to the mesh once the fence has signaled
+	BufferHandle vertexBuffer;
+	BufferHandle indexBuffer;
+	GLsizeiptr	 vertexCapacity = 0;
+	GLsizeiptr	 indexCapacity	= 0;
+	GLsync		 fence			= nullptr;
+
+	std::atomic <GLuint> stage { LOADING };
+};
+
+// what MeshLoader::Request returns right away, the mesh can be drawn once Get stops returning null
+// it belongs to the loader, only the thread that draws may touch it after that
+class MeshHandle {
+private:
+	std::shared_ptr <MeshLoadJob> job;
+
+public:
+	MeshHandle() {}
+	explicit MeshHandle(std::shared_ptr <MeshLoadJob> job) : job(std::move(job)) {}
+
+	GLboolean Ready() const {
+		return job && job->stage.load(std::memory_order_acquire) == MeshLoadJob::READY;
+	}
+
+	// the generator came up empty, e.g. a model file that could not be parsed
+	GLboolean Failed() const {
+		return job && job->stage.load(std::memory_order_acquire) == MeshLoadJob::FAILED;
+	}
+
+	MeshObject* Get() const {
+		return Ready() ? job->mesh.get() : nullptr;
+	}
+};
+
+// builds meshes without blocking the thread that draws
+// workers run the generators on the cpu or map the result from the mesh cache, a loader thread with a hidden
+// window whose context shares objects with the main one uploads them and sets a fence, and Poll on the drawing
+// context gives the buffers to the mesh once its fence has signaled
+// without a window to share with every request is built right away on the calling thread, as if made directly
+class MeshLoader {
+private:
+	static constexpr GLuint MAX_WORKERS = 4;
+
+	GLFWwindow* loaderWindow;
+
+	std::vector <std::thread> workers;
+	std::thread				  loader;
+
+	std::mutex				mutex;
+	std::condition_variable generateWake;
+	std::condition_variable uploadWake;
+
+	std::deque <std::shared_ptr <MeshLoadJob>>	generateQueue;
+	std::deque <std::shared_ptr <MeshLoadJob>>	uploadQueue;
+	std::vector <std::shared_ptr <MeshLoadJob>> fenced;		// uploaded, waiting for their fence in Poll
+
+	GLboolean stopping;
+
+	std::atomic <GLuint> pending;
+
+	void WorkerLoop() {
+		MeshObject::cpuOnly = GL_TRUE;
+
+		while (true) {
+			std::shared_ptr <MeshLoadJob> job;
+
+			{
+				std::unique_lock <std::mutex> lock(mutex);
+				generateWake.wait(lock, [this]() { return stopping || !generateQueue.empty(); });
+
+				if (stopping) { return; }
+
+				job = std::move(generateQueue.front());
+				generateQueue.pop_front();
+			}
+
+			job->mesh.reset(job->create());
+
+			if (job->mesh->triCount == 0) {
+				job->stage.store(MeshLoadJob::FAILED, std::memory_order_release);
+				pending--;
+				continue;
+			}
+
+			{
+				std::lock_guard <std::mutex> lock(mutex);
+				uploadQueue.push_back(std::move(job));
+			}
+
+			uploadWake.notify_one();
+		}
+	}
+
+	void LoaderLoop() {
+		glfwMakeContextCurrent(loaderWindow);
+
+		while (true) {
+			std::shared_ptr <MeshLoadJob> job;
+
+			{
+				std::unique_lock <std::mutex> lock(mutex);
+				uploadWake.wait(lock, [this]() { return stopping || !uploadQueue.empty(); });
+
+				if (stopping) { break; }
+
+				job = std::move(uploadQueue.front());
+				uploadQueue.pop_front();
+			}
+
+			Upload(*job);
+
+			{
+				std::lock_guard <std::mutex> lock(mutex);
+				fenced.push_back(std::move(job));
+			}
+
+			// wakes a main loop sleeping in glfwWaitEvents, so the next frame polls the fence
+			glfwPostEmptyEvent();
+		}
+
+		glfwMakeContextCurrent(nullptr);
+	}
+
+	// sized like the pool's own buffers, so they can go back to it with the mesh
+	static BufferHandle CreateBuffer(GLsizeiptr size, const void* data, GLsizeiptr& capacity) {
+		capacity = GLResourcePool::Capacity(size);
+
+		BufferHandle buffer = BufferHandle::Create();
+
+		glBindBuffer(GL_COPY_WRITE_BUFFER, buffer);
+		glBufferData(GL_COPY_WRITE_BUFFER, capacity, nullptr, GL_STATIC_DRAW);
+		if (size > 0) glBufferSubData(GL_COPY_WRITE_BUFFER, 0, size, data);
+		glBindBuffer(GL_COPY_WRITE_BUFFER, 0);
+
+		return buffer;
+	}
+
+	static void Upload(MeshLoadJob& job) {
+		MeshObject& mesh = *job.mesh;
+
+		GLsizeiptr vertexBytes = mesh.attribCount * (GLsizeiptr)mesh.vertCount * sizeof(GLfloat);
+		GLsizeiptr indexBytes  = 3 * (GLsizeiptr)mesh.triCount * sizeof(GLuint);
+
+		job.vertexBuffer = CreateBuffer(vertexBytes, mesh.vertices.data(), job.vertexCapacity);
+		job.indexBuffer	 = CreateBuffer(indexBytes, mesh.indices.data(), job.indexCapacity);
+
+		// the other context only sees the fence once the commands before it are flushed
+		job.fence = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+		glFlush();
+
+		// glBufferSubData has made its copy, the mesh does not need its own anymore
+		std::vector <GLfloat>().swap(mesh.vertices);
+		std::vector <GLuint>().swap(mesh.indices);
+	}
+
+public:
+	// set once per request, read them from any thread
+	std::atomic <GLuint> requested;
+	std::atomic <GLuint> ready;
+
+	// shareWith is the window whose context draws, null builds every request on the calling thread
+	// creates a window, so it has to be made on the main thread
+	MeshLoader(GLFWwindow* shareWith) : pending(0), requested(0), ready(0) {
+		loaderWindow = nullptr;
+		stopping	 = GL_FALSE;
+
+		if (shareWith == nullptr) { return; }
+
+		glfwWindowHint(GLFW_VISIBLE, GLFW_FALSE);
+		loaderWindow = glfwCreateWindow(1, 1, "mesh loader", nullptr, shareWith);
+
+		if (loaderWindow == nullptr) {
+			std::cout << "ERROR::MESH_LOADER::CANNOT_CREATE_SHARED_CONTEXT" << std::endl;
+			return;
+		}
+
+		GLuint cores = std::thread::hardware_concurrency();
+		GLuint workerCount = std::clamp(cores > 1 ? cores - 1 : 1u, 1u, MAX_WORKERS);
+
+		for (GLuint i = 0; i < workerCount; i++) workers.emplace_back(&MeshLoader::WorkerLoop, this);
+		loader = std::thread(&MeshLoader::LoaderLoop, this);
+	}
+
+	MeshLoader(const MeshLoader&) = delete;
+	MeshLoader& operator=(const MeshLoader&) = delete;
+
+	GLboolean Async() const {
+		return loaderWindow != nullptr;
+	}
+
+	GLuint Pending() const {
+		return pending;
+	}
+
+	// constructs Mesh from args on a worker, the arguments are copied into the request
+	// requests are started in order, ask for coarse stand ins before the meshes they stand in for
+	template <typename Mesh, typename... Args>
+	MeshHandle Request(GLuint shaderProgram, Args... args) {
+		std::shared_ptr <MeshLoadJob> job = std::make_shared <MeshLoadJob>();
+
+		job->create = [shaderProgram, args...]() -> MeshObject* {
+			Mesh* mesh = new Mesh(args...);
+			mesh->SetShader(shaderProgram);
+
+			return mesh;
+		};
+
+		requested++;
+
+		if (!Async()) {
+			job->mesh.reset(job->create());
+
+			if (job->mesh->triCount > 0) {
+				job->stage = MeshLoadJob::READY;
+				ready++;
+			}
+			else {
+				job->stage = MeshLoadJob::FAILED;
+			}
+
+			return MeshHandle(job);
+		}
+
+		pending++;
+
+		{
+			std::lock_guard <std::mutex> lock(mutex);
+			generateQueue.push_back(job);
+		}
+
+		generateWake.notify_one();
+		return MeshHandle(job);
+	}
+
+	// on the drawing context once per frame, finishes every upload whose fence has signaled and returns how many
+	GLuint Poll() {
+		if (!Async()) { return 0; }
+
+		std::vector <std::shared_ptr <MeshLoadJob>> done;
+
+		{
+			std::lock_guard <std::mutex> lock(mutex);
+
+			for (size_t i = 0; i < fenced.size(); ) {
+				GLenum status = glClientWaitSync(fenced[i]->fence, 0, 0);
+
+				if (status == GL_ALREADY_SIGNALED || status == GL_CONDITION_SATISFIED) {
+					done.push_back(std::move(fenced[i]));
+					fenced[i] = std::move(fenced.back());
+					fenced.pop_back();
+				}
+				else {
+					i++;
+				}
+			}
+		}
+
+		for (std::shared_ptr <MeshLoadJob>& job : done) {
+			glDeleteSync(job->fence);
+			job->fence = nullptr;
+
+			// binding the buffers here is what makes the other context's writes visible to this one
+			job->mesh->AdoptBuffers(std::move(job->vertexBuffer), job->vertexCapacity, std::move(job->indexBuffer), job->indexCapacity);
+
+			job->stage.store(MeshLoadJob::READY, std::memory_order_release);
+			ready++;
+			pending--;
+		}
+
+		return (GLuint)done.size();
+	}
+
+	// joins the threads and drops whatever is still loading, on the main thread with the drawing context current
+	void Shutdown() {
+		if (!Async()) { return; }
+
+		{
+			std::lock_guard <std::mutex> lock(mutex);
+			stopping = GL_TRUE;
+		}
+
+		generateWake.notify_all();
+		uploadWake.notify_all();
+
+		for (std::thread& worker : workers) worker.join();
+		loader.join();
+
+		for (std::shared_ptr <MeshLoadJob>& job : fenced) {
+			glDeleteSync(job->fence);
+
+			job->vertexBuffer.Reset();
+			job->indexBuffer.Reset();
+		}
+
+		generateQueue.clear();
+		uploadQueue.clear();
+		fenced.clear();
+
+		glfwDestroyWindow(loaderWindow);
+		loaderWindow = nullptr;
+	}
+
+	~MeshLoader() {
+		Shutdown();
+	}
+};
\ No newline at end of file
@@ -2,52 +2,151 @@
 
 #include "3d_shapes.h"
 #include "camera.hpp"
+#include "profiler.hpp"
+#include "mesh_cache.hpp"
+#include "gl_resource.hpp"
+
+#include <algorithm>
+#include <functional>
 
 class MeshObject {
 protected:
-	GLuint VBO;
-	GLuint EBO;
-	GLuint VAO;
+	// taken from and given back to GLResourcePool, so meshes can be rebuilt without new gl objects
+	BufferHandle	  VBO;
+	BufferHandle	  EBO;
+	VertexArrayHandle VAO;
 
-	virtual void BindBuffers(GLboolean elementBuffer = GL_TRUE) {
-		glBindVertexArray(VAO);
+	GLsizeiptr vertexCapacity;
+	GLsizeiptr indexCapacity;
 
-			glBindBuffer(GL_ARRAY_BUFFER, VBO);
-			glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, EBO);
+	// generators write into vertices and indices, meshes loaded from the cache never allocate them
+	virtual void GenerateVertices() {}
+
+	void AllocateArrays() {
+		this->vertices.resize(attribCount * (size_t)this->vertCount);
+		this->indices.resize(3 * (size_t)this->triCount);
+	}
+
+	// grows buffer to size bytes through the pool if needed, then writes data at the start
+	static void Fill(BufferHandle& buffer, GLsizeiptr& capacity, GLenum target, GLsizeiptr size, const void* data) {
+		if (size > capacity) {
+			GLResourcePool::ReleaseBuffer(std::move(buffer), capacity);
+			buffer = GLResourcePool::AcquireBuffer(size, capacity);
+		}
+
+		glBindBuffer(target, buffer);
+		if (size > 0) glBufferSubData(target, 0, size, data);
+	}
+
+	void ComputeBounds() {
+		boundsMin = glm::vec3(vertices[0], vertices[1], vertices[2]);
+		boundsMax = boundsMin;
 
-			glBufferData(GL_ARRAY_BUFFER, attribCount * this->vertCount * sizeof(GLfloat), this->vertices, GL_STATIC_DRAW);
+		for (GLuint i = 1; i < vertCount; i++) {
+			glm::vec3 point(vertices[i * attribCount], vertices[i * attribCount + 1], vertices[i * attribCount + 2]);
+
+			boundsMin = glm::min(boundsMin, point);
+			boundsMax = glm::max(boundsMax, point);
+		}
+	}
+
+	// uploads from the mesh cache mapping if the key is cached, otherwise generates the mesh and caches it
+	void Build(const MeshCacheKey& key) {
+		CachedMesh cached;
+
+		// the upload reads vertCount and triCount from the mapping, a file with other counts is a miss
+		if (MeshCache::Load(key, vertCount, triCount, attribCount, cached)) {
+			boundsMin = glm::make_vec3(cached.header->boundsMin);
+			boundsMax = glm::make_vec3(cached.header->boundsMax);
+
+			UploadBuffers(cached.vertices, cached.indices);
+			return;
+		}
+
+		AllocateArrays();
+		GenerateVertices();
+		ComputeBounds();
+
+		BindBuffers();
 
-			if (elementBuffer) {
-				glBufferData(GL_ELEMENT_ARRAY_BUFFER, 3 * this->triCount * sizeof(GLuint), this->indices, GL_STATIC_DRAW);
+		MeshCache::Store(key, vertCount, triCount, attribCount, vertices.data(), indices.data(), boundsMin, boundsMax);
+	}
+
+	virtual void BindBuffers(GLboolean elementBuffer = GL_TRUE) {
+		UploadBuffers(this->vertices.data(), elementBuffer ? this->indices.data() : nullptr);
+	}
+
+	// vertexData is interleaved attribCount floats per vertex, indexData can be null to leave the EBO empty
+	void UploadBuffers(const GLfloat* vertexData, const GLuint* indexData) {
+		// cpu only meshes keep their own copy of the data instead
+		if (cpuOnly) {
+			if (this->vertices.empty()) {
+				AllocateArrays();
+
+				std::copy(vertexData, vertexData + attribCount * (size_t)this->vertCount, this->vertices.begin());
+				if (indexData != nullptr) std::copy(indexData, indexData + 3 * (size_t)this->triCount, this->indices.begin());
 			}
 
-			glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, attribCount * sizeof(GLfloat), (void*)0);
-			if (attribCount == 6) {
-				glVertexAttribPointer(1, 3, GL_FLOAT, GL_FALSE, attribCount * sizeof(GLfloat), (void*)(3 * sizeof(GLfloat)));
-				glEnableVertexAttribArray(1);
+			return;
+		}
+
+		glBindVertexArray(VAO);
+
+			Fill(VBO, vertexCapacity, GL_ARRAY_BUFFER, attribCount * (GLsizeiptr)this->vertCount * sizeof(GLfloat), vertexData);
+
+			if (indexData != nullptr) {
+				Fill(EBO, indexCapacity, GL_ELEMENT_ARRAY_BUFFER, 3 * (GLsizeiptr)this->triCount * sizeof(GLuint), indexData);
 			}
-			glEnableVertexAttribArray(0);
+			else {
+				glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, EBO);
+			}
+
+			SetAttributes();
 
 		glBindVertexArray(0);
 	}
 
+	// with the vertex array and the vertex buffer bound
+	void SetAttributes() {
+		glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, attribCount * sizeof(GLfloat), (void*)0);
+		glEnableVertexAttribArray(0);
+
+		// a recycled vertex array may still have the normal attribute enabled
+		if (attribCount == 6) {
+			glVertexAttribPointer(1, 3, GL_FLOAT, GL_FALSE, attribCount * sizeof(GLfloat), (void*)(3 * sizeof(GLfloat)));
+			glEnableVertexAttribArray(1);
+		}
+		else {
+			glDisableVertexAttribArray(1);
+		}
+	}
+
 public:
+	// set before creating meshes to skip every gl call and keep vertices and indices on the cpu,
+	// for the software rasterizer on machines without a gl context and for meshes built on worker threads
+	// per thread, so workers can build cpu only meshes while the main thread keeps creating gl ones
+	inline static thread_local GLboolean cpuOnly = GL_FALSE;
+
 	GLuint vertCount;
 	GLuint triCount;
 
-	GLfloat* vertices;
-	GLuint*  indices;
+	std::vector <GLfloat> vertices;
+	std::vector <GLuint>  indices;
 
 	GLuint shaderProgram;
 	GLuint attribCount;
 
 	glm::vec3 position;
-	glm::mat4 model_mat;
+	glm::mat4 model_mat;	// set from a SceneGraph node each frame, the position above is baked into the vertices
+
+	glm::vec3 boundsMin;
+	glm::vec3 boundsMax;
 
 	MeshObject(GLuint vertCount, GLuint triCount, GLuint attribs = 3) {
-		glGenBuffers(1, &VBO);
-		glGenBuffers(1, &EBO);
-		glGenVertexArrays(1, &VAO);
+		vertexCapacity = indexCapacity = 0;
+
+		// buffers are taken from the pool once the size is known
+		if (!cpuOnly) VAO = GLResourcePool::AcquireVertexArray();
 
 		position = glm::vec3(0.0f, 0.0f, 0.0f);
 
@@ -55,28 +154,36 @@ public:
 		this->triCount  = triCount;
 		this->attribCount = attribs;
 
-		this->vertices = new GLfloat[attribs * this->vertCount];
-		this->indices  = new GLuint[3 * this->triCount];
+		boundsMin = glm::vec3(0.0f, 0.0f, 0.0f);
+		boundsMax = glm::vec3(0.0f, 0.0f, 0.0f);
 
 		this->shaderProgram = 0;
 		this->model_mat = glm::mat4(1.0f);
 	}
 
 	void SetMats(Camera camera) {
+		PROFILE_SCOPE("MeshObject::SetMats");
+
 		glUseProgram(shaderProgram);
 
-		GLuint proj_loc = glGetUniformLocation(shaderProgram, "projection");
-		GLuint view_loc = glGetUniformLocation(shaderProgram, "view");
-		GLuint norm_loc = glGetUniformLocation(shaderProgram, "normal_mat");
+		GLuint proj_loc	 = glGetUniformLocation(shaderProgram, "projection");
+		GLuint view_loc	 = glGetUniformLocation(shaderProgram, "view");
+		GLuint model_loc = glGetUniformLocation(shaderProgram, "model");
+		GLuint norm_loc	 = glGetUniformLocation(shaderProgram, "normal_mat");
+
+		glm::mat4 view = camera.GetViewMat();
 
 		if (proj_loc != -1) glUniformMatrix4fv(proj_loc, 1, GL_FALSE, glm::value_ptr(camera.projection_mat));
-		if (view_loc != -1) glUniformMatrix4fv(view_loc, 1, GL_FALSE, glm::value_ptr(camera.GetViewMat()));
-		if (norm_loc != -1) glUniformMatrix3fv(norm_loc, 1, GL_FALSE, glm::value_ptr(glm::mat3(glm::transpose(glm::inverse(camera.GetViewMat())))));
+		if (view_loc != -1) glUniformMatrix4fv(view_loc, 1, GL_FALSE, glm::value_ptr(view));
+		if (model_loc != -1) glUniformMatrix4fv(model_loc, 1, GL_FALSE, glm::value_ptr(model_mat));
+		if (norm_loc != -1) glUniformMatrix3fv(norm_loc, 1, GL_FALSE, glm::value_ptr(glm::mat3(glm::transpose(glm::inverse(view * model_mat)))));
 
 		glUseProgram(0);
 	}
 
 	virtual void Draw(Camera camera, GLenum polygonMode = GL_FILL, GLenum drawMode = GL_TRIANGLES) {
+		PROFILE_SCOPE("MeshObject::Draw");
+
 		SetMats(camera);
 
 		glPolygonMode(GL_FRONT_AND_BACK, polygonMode);
@@ -90,28 +197,91 @@ public:
 		glBindVertexArray(0);
 	}
 
+	// indexed meshes only, with the program and uniforms already set by the caller, see MultiView
+	void DrawInstanced(GLsizei instances, GLenum drawMode = GL_TRIANGLES) {
+		glBindVertexArray(this->VAO);
+		glDrawElementsInstanced(drawMode, 3 * this->triCount, GL_UNSIGNED_INT, 0, instances);
+		glBindVertexArray(0);
+	}
+
 	void SetShader(GLuint program) {
 		this->shaderProgram = program;
 	}
 
+	// takes over buffers another context filled with the vertices and indices of this cpu only mesh, see MeshLoader
+	// the capacities have to come from GLResourcePool::Capacity, the buffers go back to the pool with the mesh
+	// the vertex array is not shared between contexts, so it is made here on the one that draws
+	void AdoptBuffers(BufferHandle&& vertexBuffer, GLsizeiptr vertexCapacity, BufferHandle&& indexBuffer, GLsizeiptr indexCapacity) {
+		GLResourcePool::ReleaseBuffer(std::move(VBO), this->vertexCapacity);
+		GLResourcePool::ReleaseBuffer(std::move(EBO), this->indexCapacity);
+
+		VBO = std::move(vertexBuffer);
+		EBO = std::move(indexBuffer);
+
+		this->vertexCapacity = vertexCapacity;
+		this->indexCapacity	 = indexCapacity;
+
+		if (VAO == 0) VAO = GLResourcePool::AcquireVertexArray();
+
+		glBindVertexArray(VAO);
+
+			glBindBuffer(GL_ARRAY_BUFFER, VBO);
+			glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, EBO);
+
+			SetAttributes();
+
+		glBindVertexArray(0);
+	}
+
+	// runs the generator again on the cpu, without the mesh cache or any gl call, for the benchmarks
+	void Generate() {
+		AllocateArrays();
+		GenerateVertices();
+		ComputeBounds();
+	}
+
+	// two triangles per quad of a grid closed in both directions, rings of segments vertices one after another
+	// the torus and the tubes share this layout
+	static void ClosedGridIndices(GLuint rings, GLuint segments, GLuint* out) {
+		for (GLuint i = 0; i < rings; i++) {
+			GLuint row	   = i * segments;
+			GLuint nextRow = ((i + 1 == rings) ? 0 : i + 1) * segments;
+
+			for (GLuint j = 0; j < segments; j++) {
+				GLuint next = (j + 1 == segments) ? 0 : j + 1;
+
+				*out++ = row + j;
+				*out++ = row + next;
+				*out++ = nextRow + next;
+
+				*out++ = row + j;
+				*out++ = nextRow + j;
+				*out++ = nextRow + next;
+			}
+		}
+	}
+
 	void Rotate(glm::vec3 axis, GLfloat angle) {
 		model_mat = glm::rotate(model_mat, angle, axis);
 	}
-	
-	~MeshObject() {
-		glDeleteVertexArrays(1, &VAO);
-		glDeleteBuffers(1, &VBO);
-		glDeleteBuffers(1, &EBO);
 
+	// meshes own gl objects, they can be moved into containers but not copied
+	MeshObject(const MeshObject&) = delete;
+	MeshObject& operator=(const MeshObject&) = delete;
+
+	MeshObject(MeshObject&&) = default;
+	MeshObject& operator=(MeshObject&&) = default;
 
-		delete[] this->vertices;
-		delete[] this->indices;
+	virtual ~MeshObject() {
+		GLResourcePool::ReleaseVertexArray(std::move(VAO));
+		GLResourcePool::ReleaseBuffer(std::move(VBO), vertexCapacity);
+		GLResourcePool::ReleaseBuffer(std::move(EBO), indexCapacity);
 	}
 };
 
 class Disk: public MeshObject {
 private:
-	void GenerateVertices() {
+	void GenerateVertices() override {
 		GLfloat offset = (2 * PI) / (this->vertCount - 1);
 
 		// add a center vert for triangulation, terrible way to triangulate for now
@@ -148,15 +318,13 @@ public:
 		this->position = cPos;
 		this->resolution = resolution;
 
-		GenerateVertices();
-
-		BindBuffers();
+		Build(MeshCacheKey("disk") << radius << resolution << cPos);
 	}
 };
 
 class UVSphere : public MeshObject {
 private:
-	void GenerateVertices() {
+	void GenerateVertices() override {
 		GLfloat offsetY = 180.0f / (divisionsY + 1);
 		GLfloat offsetX = 360.0f / divisionsX;
 
@@ -262,15 +430,13 @@ public:
 		this->divisionsX = divX;
 		this->divisionsY = divY;
 
-		GenerateVertices();
-
-		BindBuffers();
+		Build(MeshCacheKey("uvsphere") << radius << position << divX << divY);
 	}
 };
 
 class Torus : public MeshObject {
 private:
-	void GenerateVertices() {
+	void GenerateVertices() override {
 		GLfloat offsetR = 360.0f / divisionsR;
 		GLfloat offsetT = 360.0f / divisionsT;
 
@@ -307,23 +473,11 @@ private:
 			phi += offsetT;
 		}
 
-		index = 0;
-
 		// 
 		// generate indices 
 		//
 
-		for (GLuint i = 0; i < divisionsT; i++) {
-			for (GLuint j = 0; j < divisionsR; j++) {
-				indices[index++] = i * divisionsR + j;
-				indices[index++] = i * divisionsR + ((j + 1 == divisionsR) ? 0 : (j + 1));
-				indices[index++] = ((i + 1 == divisionsT) ? 0 : (i + 1)) * divisionsR + ((j + 1 == divisionsR) ? 0 : (j + 1));
-
-				indices[index++] = i * divisionsR + j;
-				indices[index++] = ((i + 1 == divisionsT) ? 0 : (i + 1)) * divisionsR + j;
-				indices[index++] = ((i + 1 == divisionsT) ? 0 : (i + 1)) * divisionsR + ((j + 1 == divisionsR) ? 0 : (j + 1));
-			}
-		}
+		ClosedGridIndices(divisionsT, divisionsR, indices.data());
 	}
 
 public:
@@ -341,111 +495,284 @@ public:
 		this->divisionsR  = divR;
 		this->divisionsT  = divT;
 
-		GenerateVertices();
-
-		BindBuffers();
+		Build(MeshCacheKey("torus") << position << innerR << outerR << divR << divT);
 	}
 };
 
-class Trefoil : public MeshObject {
+// closed curve over t in [0, 1), curve(1) has to equal curve(0)
+typedef std::function <glm::vec3(GLfloat)> ClosedCurve;
+
+// tube of constant radius around a closed curve, rings are placed where the curve bends until the
+// surface is within tolerance of the true tube, and oriented with rotation minimizing frames so they do not twist
+class TubeMesh : public MeshObject {
 private:
-	void GenerateVertices() {
-		GLfloat offsetL = 360.0f / divisionsL;
-		GLfloat offsetN = 360.0f / divisionsN;
+	static constexpr GLuint MIN_SEGMENTS	 = 8;
+	static constexpr GLuint MAX_SUBDIVIDE	 = 16;
+	static constexpr GLuint DENSITY_SAMPLES = 1024;
 
-		GLfloat theta = 0.0;
-		GLuint index = 0;
+	static void Refine(const ClosedCurve& curve, GLfloat radius, GLfloat tolerance, GLfloat t0, GLfloat t1, GLuint depth, std::vector <GLfloat>& samples) {
+		if (depth < MAX_SUBDIVIDE && SegmentError(curve, radius, t0, t1) > tolerance) {
+			GLfloat middle = 0.5f * (t0 + t1);
 
-		std::vector <glm::vec3> points;
+			Refine(curve, radius, tolerance, t0, middle, depth + 1, samples);
+			Refine(curve, radius, tolerance, middle, t1, depth + 1, samples);
+		}
+		else {
+			samples.push_back(t0);
+		}
+	}
 
-		for (GLuint i = 0; i < divisionsL; i++) {
-			glm::vec3 point(
-				radiusT * ((glm::sin(glm::radians(theta)) + 2.0f * sin(2 * glm::radians(theta)))) * 0.33f,
-				radiusT * ((glm::cos(glm::radians(theta)) - 2.0f * cos(2 * glm::radians(theta)))) * 0.33f,
-				radiusT * -glm::sin(3 * glm::radians(theta)) * 0.33f
-			);
-			points.push_back(point);
+	glm::vec3 Tangent(GLfloat t) const {
+		const GLfloat h = 1e-4f;
+		return glm::normalize(curve(t + h < 1.0f ? t + h : t + h - 1.0f) - curve(t >= h ? t - h : t - h + 1.0f));
+	}
+
+protected:
+	ClosedCurve curve;
+	std::vector <GLfloat> samples;		// curve parameter of every ring
 
-			theta += offsetL;
+	void GenerateVertices() override {
+		GLuint rings = (GLuint)samples.size();
+
+		std::vector <glm::vec3> points(rings), tangents(rings), normals(rings);
+		std::vector <GLfloat>	lengths(rings + 1, 0.0f);
+
+		for (GLuint i = 0; i < rings; i++) {
+			points[i]	= curve(samples[i]);
+			tangents[i] = Tangent(samples[i]);
 		}
 
-		const GLfloat mPI = 3.142f;
+		// any normal to start with, the one least aligned with the tangent
+		glm::vec3 axis = (std::fabs(tangents[0].x) < 0.5f) ? glm::vec3(1.0f, 0.0f, 0.0f) : glm::vec3(0.0f, 1.0f, 0.0f);
+		normals[0] = glm::normalize(glm::cross(tangents[0], axis));
 
-		for (GLuint i = 0; i < divisionsL; i++) {
+		// double reflection, each normal is carried to the next ring by reflecting across the chord
+		// and then across the bisector of the reflected and the next tangent
+		glm::vec3 normal = normals[0];
 
-			GLuint prev = (i - 1) == -1 ? divisionsL - 1 : (i - 1);
-			GLuint next = (i + 1) == divisionsL ? 0 : (i + 1);
+		for (GLuint i = 0; i < rings; i++) {
+			GLuint next = (i + 1 == rings) ? 0 : i + 1;
 
-			glm::vec3 v1(0.0f, 0.0f, 1.0f);
-			glm::vec3 v2 = glm::normalize(glm::normalize(points[next] - points[i]) + glm::normalize(points[i] - points[prev]));
+			glm::vec3 chord = points[next] - points[i];
+			GLfloat chordSq = glm::dot(chord, chord);
+			lengths[i + 1]	= lengths[i] + std::sqrt(chordSq);
 
-			GLfloat axAngle = 0.0f;
-			GLfloat z = glm::length(v1) * glm::length(v2);
-			if (z != 0) axAngle = glm::acos(glm::dot(v1, v2) / z);
+			if (chordSq > 0.0f) {
+				glm::vec3 reflectedNormal  = normal - (2.0f / chordSq) * glm::dot(chord, normal) * chord;
+				glm::vec3 reflectedTangent = tangents[i] - (2.0f / chordSq) * glm::dot(chord, tangents[i]) * chord;
 
-			glm::quat q(glm::cos(axAngle / 2), glm::sin(axAngle / 2) * glm::cross(v1, v2));
-			q = glm::normalize(q);
+				glm::vec3 bisector = tangents[next] - reflectedTangent;
+				GLfloat bisectorSq = glm::dot(bisector, bisector);
 
-			GLfloat phi = 0.0f;
+				normal = (bisectorSq > 0.0f) ? reflectedNormal - (2.0f / bisectorSq) * glm::dot(bisector, reflectedNormal) * bisector : reflectedNormal;
+			}
 
-			for (GLuint j = 0; j < divisionsN; j++) {
-				glm::vec3 pointR(
-					radiusN * glm::cos(glm::radians(phi)),
-					radiusN * glm::sin(glm::radians(phi)),
-					0.0f
-				);
+			if (next != 0) normals[next] = normal;
+		}
 
-				glm::mat4 rot = glm::toMat4(q);
-				pointR = rot * glm::vec4(pointR, 1.0f);
+		// a closed curve generally comes back with its frame turned, the mismatch is spread over the arc length
+		glm::vec3 binormal0 = glm::cross(tangents[0], normals[0]);
+		GLfloat twist = std::atan2(glm::dot(normal, binormal0), glm::dot(normal, normals[0]));
 
-				pointR += points[i];
+		GLfloat offsetN = glm::two_pi<GLfloat>() / divisionsN;
+		GLuint index = 0;
 
-				// vertices
-				vertices[index++] = pointR.x;
-				vertices[index++] = pointR.y;
-				vertices[index++] = pointR.z;
+		for (GLuint i = 0; i < rings; i++) {
+			GLfloat angle = -twist * lengths[i] / lengths[rings];
 
-				glm::vec3 normal = glm::normalize(pointR - points[i]);
+			glm::vec3 binormal = glm::cross(tangents[i], normals[i]);
+			glm::vec3 n = std::cos(angle) * normals[i] + std::sin(angle) * binormal;
+			glm::vec3 b = glm::cross(tangents[i], n);
 
-				vertices[index++] = normal.x;
-				vertices[index++] = normal.y;
-				vertices[index++] = normal.z;
+			for (GLuint j = 0; j < divisionsN; j++) {
+				GLfloat phi = j * offsetN;
+				glm::vec3 direction = std::cos(phi) * n + std::sin(phi) * b;
+				glm::vec3 point = points[i] + radiusN * direction;
 
-				phi += offsetN;
+				vertices[index++] = point.x;
+				vertices[index++] = point.y;
+				vertices[index++] = point.z;
+
+				vertices[index++] = direction.x;
+				vertices[index++] = direction.y;
+				vertices[index++] = direction.z;
 			}
 		}
 
 		// generate indices
 
-		index = 0;
+		ClosedGridIndices(rings, divisionsN, indices.data());
+	}
 
-		for (GLuint i = 0; i < divisionsL; i++) {
-			for (GLuint j = 0; j < divisionsN; j++) {
-				indices[index++] = i * divisionsN + j;
-				indices[index++] = i * divisionsN + ((j + 1 == divisionsN) ? 0 : (j + 1));
-				indices[index++] = ((i + 1 == divisionsL) ? 0 : (i + 1)) * divisionsN + ((j + 1 == divisionsN) ? 0 : (j + 1));
+	// samples the curve and sets the counts, derived classes call Build afterwards
+	TubeMesh(ClosedCurve curve, GLfloat radius, GLfloat tolerance, GLuint divN) : MeshObject(0, 0, 6) {
+		this->curve		 = std::move(curve);
+		this->radiusN	 = radius;
+		this->tolerance	 = tolerance;
+		this->divisionsN = divN;
+
+		samples = SampleAdaptive(this->curve, radius, tolerance);
+
+		vertCount = (GLuint)samples.size() * divN;
+		triCount  = 2 * vertCount;
+	}
+
+public:
+	GLuint	divisionsN;
+	GLfloat radiusN;
+	GLfloat tolerance;
+
+	// how far the tube surface strays from the straight segment between two rings, the curve is probed at
+	// three points and the outer side of the tube bends with radius 1 / curvature + radius, which scales the error
+	static GLfloat SegmentError(const ClosedCurve& curve, GLfloat radius, GLfloat t0, GLfloat t1) {
+		glm::vec3 a = curve(t0);
+		glm::vec3 chord = curve(t1 < 1.0f ? t1 : 0.0f) - a;
+		GLfloat chordSq = glm::dot(chord, chord);
+
+		GLfloat sagitta = 0.0f;
+
+		for (GLuint k = 1; k < 4; k++) {
+			glm::vec3 p = curve(t0 + (t1 - t0) * k * 0.25f);
+			GLfloat u = (chordSq > 0.0f) ? glm::clamp(glm::dot(p - a, chord) / chordSq, 0.0f, 1.0f) : 0.0f;
+
+			sagitta = std::max(sagitta, glm::length(p - (a + u * chord)));
+		}
+
+		if (chordSq <= 0.0f) { return sagitta; }
+
+		GLfloat curvature = 8.0f * sagitta / chordSq;
+		return sagitta * (1.0f + radius * curvature);
+	}
+
+	// curve parameters of the rings, spaced so every segment gets about the same error
+	// a segment of length l where the curve bends with curvature k deviates by k l^2 / 8, so the ring density
+	// along the arc has to follow sqrt(k (1 + radius k) / (8 tolerance)), segments still above tolerance are halved
+	static std::vector <GLfloat> SampleAdaptive(const ClosedCurve& curve, GLfloat radius, GLfloat tolerance) {
+		std::vector <glm::vec3> fine(DENSITY_SAMPLES);
+		for (GLuint k = 0; k < DENSITY_SAMPLES; k++) fine[k] = curve((GLfloat)k / DENSITY_SAMPLES);
 
-				indices[index++] = i * divisionsN + j;
-				indices[index++] = ((i + 1 == divisionsL) ? 0 : (i + 1)) * divisionsN + j;
-				indices[index++] = ((i + 1 == divisionsL) ? 0 : (i + 1)) * divisionsN + ((j + 1 == divisionsN) ? 0 : (j + 1));
+		// curvature at each fine sample from the turn between its two chords
+		std::vector <GLfloat> curvature(DENSITY_SAMPLES);
+
+		for (GLuint k = 0; k < DENSITY_SAMPLES; k++) {
+			glm::vec3 before = fine[k] - fine[(k + DENSITY_SAMPLES - 1) % DENSITY_SAMPLES];
+			glm::vec3 after	 = fine[(k + 1) % DENSITY_SAMPLES] - fine[k];
+
+			GLfloat lengths = glm::length(before) + glm::length(after);
+			GLfloat turn	= std::atan2(glm::length(glm::cross(before, after)), glm::dot(before, after));
+
+			curvature[k] = (lengths > 0.0f) ? 2.0f * turn / lengths : 0.0f;
+		}
+
+		std::vector <GLfloat> cumulative(DENSITY_SAMPLES + 1, 0.0f);
+
+		for (GLuint k = 0; k < DENSITY_SAMPLES; k++) {
+			GLfloat bend = 0.5f * (curvature[k] + curvature[(k + 1) % DENSITY_SAMPLES]);
+			GLfloat length = glm::length(fine[(k + 1) % DENSITY_SAMPLES] - fine[k]);
+
+			cumulative[k + 1] = cumulative[k] + length * std::sqrt(bend * (1.0f + radius * bend) / (8.0f * tolerance));
+		}
+
+		GLuint rings = std::max(MIN_SEGMENTS, (GLuint)std::ceil(cumulative[DENSITY_SAMPLES]));
+
+		// equal steps of the cumulative density, mapped back to the curve parameter
+		std::vector <GLfloat> spaced(rings);
+		GLuint k = 0;
+
+		for (GLuint i = 0; i < rings; i++) {
+			GLfloat target = cumulative[DENSITY_SAMPLES] * i / rings;
+			while (k + 1 < DENSITY_SAMPLES && cumulative[k + 1] <= target) k++;
+
+			GLfloat span = cumulative[k + 1] - cumulative[k];
+			GLfloat fraction = (span > 0.0f) ? (target - cumulative[k]) / span : 0.0f;
+
+			spaced[i] = (k + fraction) / DENSITY_SAMPLES;
+		}
+
+		std::vector <GLfloat> samples;
+		samples.reserve(rings);
+
+		for (GLuint i = 0; i < rings; i++) {
+			Refine(curve, radius, tolerance, spaced[i], (i + 1 < rings) ? spaced[i + 1] : 1.0f, 0, samples);
+		}
+
+		return samples;
+	}
+
+	// the fewest evenly spaced rings within tolerance, for comparison with SampleAdaptive
+	static GLuint UniformRingsFor(const ClosedCurve& curve, GLfloat radius, GLfloat tolerance) {
+		auto withinTolerance = [&](GLuint rings) {
+			for (GLuint i = 0; i < rings; i++) {
+				if (SegmentError(curve, radius, (GLfloat)i / rings, (GLfloat)(i + 1) / rings) > tolerance) return false;
 			}
+
+			return true;
+		};
+
+		GLuint high = MIN_SEGMENTS;
+		while (!withinTolerance(high) && high < (MIN_SEGMENTS << MAX_SUBDIVIDE)) high *= 2;
+
+		GLuint low = high / 2;
+		while (high - low > 1) {
+			GLuint middle = (low + high) / 2;
+
+			if (withinTolerance(middle)) high = middle;
+			else low = middle;
 		}
+
+		return high;
 	}
 
+	// world space error that shows up as pixels on screen at distance, for a vertical field of view in radians
+	static GLfloat ScreenTolerance(GLfloat pixels, GLfloat distance, GLfloat fovY, GLfloat screenHeight) {
+		return pixels * 2.0f * distance * std::tan(0.5f * fovY) / screenHeight;
+	}
+
+	GLuint RingCount() const {
+		return (GLuint)samples.size();
+	}
+};
+
+class Trefoil : public TubeMesh {
 public:
-	GLuint divisionsL, divisionsN;
-	GLfloat radiusN, radiusT;
+	GLfloat radiusT;
+
+	static ClosedCurve Curve(glm::vec3 position, GLfloat radT) {
+		return [position, radT](GLfloat t) {
+			GLfloat theta = glm::two_pi<GLfloat>() * t;
+
+			return position + radT * 0.33f * glm::vec3(
+				std::sin(theta) + 2.0f * std::sin(2.0f * theta),
+				std::cos(theta) - 2.0f * std::cos(2.0f * theta),
+				-std::sin(3.0f * theta)
+			);
+		};
+	}
 
-	Trefoil(glm::vec3 position, GLuint divL, GLuint divN, GLfloat radN = 0.125f, GLfloat radT = 1.0f) : MeshObject(divL * divN, divL * divN * 2, 6) {
+	// tolerance is in world units, see ScreenTolerance for a pixel bound
+	Trefoil(glm::vec3 position, GLfloat tolerance, GLuint divN, GLfloat radN = 0.125f, GLfloat radT = 1.0f) : TubeMesh(Curve(position, radT), radN, tolerance, divN) {
 		this->position = position;
-		this->divisionsL = divL;
-		this->divisionsN = divN;
+		this->radiusT  = radT;
 
-		this->radiusN = radN;
-		this->radiusT = radT;
+		Build(MeshCacheKey("trefoil") << position << tolerance << divN << radN << radT);
+	}
+};
 
-		GenerateVertices();
+// p turns around the axis while the tube winds q times around the core, the trefoil is a variant of (2, 3)
+class TorusKnot : public TubeMesh {
+public:
+	static ClosedCurve Curve(glm::vec3 position, GLuint p, GLuint q, GLfloat scale) {
+		return [position, p, q, scale](GLfloat t) {
+			GLfloat theta = glm::two_pi<GLfloat>() * t;
+			GLfloat r = std::cos(q * theta) + 2.0f;
 
-		BindBuffers();
+			return position + scale * glm::vec3(r * std::cos(p * theta), r * std::sin(p * theta), -std::sin(q * theta));
+		};
+	}
+
+	TorusKnot(glm::vec3 position, GLuint p, GLuint q, GLfloat tolerance, GLuint divN, GLfloat radN = 0.125f, GLfloat scale = 0.33f) : TubeMesh(Curve(position, p, q, scale), radN, tolerance, divN) {
+		this->position = position;
+
+		Build(MeshCacheKey("torusknot") << position << p << q << tolerance << divN << radN << scale);
 	}
 };
\ No newline at end of file
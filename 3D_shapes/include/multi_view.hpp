@@ -0,0 +1,126 @@
+#pragma once
+
+#include "3d_shapes.h"
+#include "camera.hpp"
+#include "profiler.hpp"
+#include "gl_resource.hpp"
+#include "mesh_object.hpp"
+#include "frustum.hpp"
+
+#include <iostream>
+
+// draws meshes into up to four views of one target with a single instanced draw call per mesh, see multiViewVert.glsl
+// the cameras go to the gpu once per frame in a uniform buffer, per mesh only the model matrix and the visible views change,
+// so the cpu cost of a frame hardly depends on the number of views
+class MultiView {
+public:
+	static constexpr GLuint MAX_VIEWS = 4;
+	static constexpr GLuint VIEWS_BINDING = 0;
+
+private:
+	// matches the Views block under std140, arrays of mat4 and vec4 have no padding
+	struct ViewBlock {
+		glm::mat4 viewMats[MAX_VIEWS];
+		glm::mat4 projections[MAX_VIEWS];
+		glm::vec4 viewRects[MAX_VIEWS];
+	};
+
+	BufferHandle UBO;
+	ViewBlock	 block;
+
+	Frustum frustums[MAX_VIEWS];
+
+public:
+	GLuint viewCount;
+	GLuint shaderProgram;
+
+	// mesh draws submitted and views they skipped during the current frame
+	GLuint drawCount;
+	GLuint culledCount;
+
+	MultiView() {
+		UBO = BufferHandle::Create();
+
+		glBindBuffer(GL_UNIFORM_BUFFER, UBO);
+		glBufferData(GL_UNIFORM_BUFFER, sizeof(ViewBlock), nullptr, GL_DYNAMIC_DRAW);
+		glBindBuffer(GL_UNIFORM_BUFFER, 0);
+
+		block = ViewBlock();
+
+		viewCount = 0;
+		shaderProgram = 0;
+		drawCount = culledCount = 0;
+	}
+
+	void SetShader(GLuint program) {
+		this->shaderProgram = program;
+
+		GLuint blockIndex = glGetUniformBlockIndex(program, "Views");
+		if (blockIndex != GL_INVALID_INDEX) glUniformBlockBinding(program, blockIndex, VIEWS_BINDING);
+	}
+
+	// rect is x0 y0 x1 y1 in normalized device coordinates of the target, the projection should match its aspect
+	void SetView(GLuint view, Camera camera, glm::vec4 rect) {
+		if (view >= MAX_VIEWS) {
+			std::cout << "ERROR::MULTI_VIEW::TOO_MANY_VIEWS" << std::endl;
+			return;
+		}
+
+		block.viewMats[view]	= camera.GetViewMat();
+		block.projections[view] = camera.projection_mat;
+		block.viewRects[view]	= rect;
+
+		frustums[view] = Frustum(block.projections[view] * block.viewMats[view]);
+
+		if (view >= viewCount) viewCount = view + 1;
+	}
+
+	// uploads the cameras, call once per frame after the views are set and before the first Draw
+	void Begin() {
+		PROFILE_SCOPE("MultiView::Begin");
+
+		glBindBuffer(GL_UNIFORM_BUFFER, UBO);
+		glBufferSubData(GL_UNIFORM_BUFFER, 0, sizeof(ViewBlock), &block);
+		glBindBuffer(GL_UNIFORM_BUFFER, 0);
+
+		glBindBufferBase(GL_UNIFORM_BUFFER, VIEWS_BINDING, UBO);
+
+		for (GLuint i = 0; i < MAX_VIEWS; i++) glEnable(GL_CLIP_DISTANCE0 + i);
+
+		drawCount = culledCount = 0;
+	}
+
+	void End() {
+		for (GLuint i = 0; i < MAX_VIEWS; i++) glDisable(GL_CLIP_DISTANCE0 + i);
+	}
+
+	// one instance per view whose frustum the world space bounds of the mesh touch, nothing at all if none does
+	void Draw(MeshObject& mesh, GLenum polygonMode = GL_FILL) {
+		PROFILE_SCOPE("MultiView::Draw");
+
+		glm::vec3 worldCenter, worldExtent;
+		Frustum::WorldBox(mesh.model_mat, mesh.boundsMin, mesh.boundsMax, worldCenter, worldExtent);
+
+		GLint visible[MAX_VIEWS] = { 0, 0, 0, 0 };
+		GLsizei instances = 0;
+
+		for (GLuint view = 0; view < viewCount; view++) {
+			if (frustums[view].Intersects(worldCenter, worldExtent)) visible[instances++] = (GLint)view;
+			else culledCount++;
+		}
+
+		if (instances == 0) { return; }
+
+		glUseProgram(shaderProgram);
+
+			glUniformMatrix4fv(glGetUniformLocation(shaderProgram, "model"), 1, GL_FALSE, glm::value_ptr(mesh.model_mat));
+			glUniform4iv(glGetUniformLocation(shaderProgram, "viewIndices"), 1, visible);
+
+			glPolygonMode(GL_FRONT_AND_BACK, polygonMode);
+			mesh.DrawInstanced(instances);
+
+		glUseProgram(0);
+
+		drawCount++;
+	}
+};
\ No newline at end of file
@@ -0,0 +1,59 @@
+#pragma once
+
+#include "3d_shapes.h"
+#include "shader.hpp"
+#include "gl_resource.hpp"
+#include "render_target.hpp"
+
+// final pass from the scene target to an output target of window size, see fxaaFrag.glsl
+// upscales whatever part of the scene target was drawn and anti-aliases it in the same pass, in place of msaa
+class PostProcess {
+private:
+	VertexArrayHandle VAO;		// the core profile needs one bound, the triangle comes from gl_VertexID
+	Shader shader;
+
+public:
+	GLboolean fxaa;
+
+	PostProcess() : shader("./shaders/postVert.glsl", "./shaders/fxaaFrag.glsl") {
+		VAO	 = VertexArrayHandle::Create();
+		fxaa = GL_TRUE;
+	}
+
+	// source has to be single sampled, its texture is read directly
+	void Apply(const RenderTarget& source, RenderTarget& destination) {
+		GLboolean depthTest = glIsEnabled(GL_DEPTH_TEST);
+		GLboolean blend		= glIsEnabled(GL_BLEND);
+
+		glDisable(GL_DEPTH_TEST);
+		glDisable(GL_BLEND);
+
+		destination.Bind();
+		glPolygonMode(GL_FRONT_AND_BACK, GL_FILL);
+
+		GLfloat texelX = 1.0f / source.width;
+		GLfloat texelY = 1.0f / source.height;
+
+		glUseProgram(shader.Program);
+
+			glUniform1i(glGetUniformLocation(shader.Program, "source"), 0);
+			glUniform1i(glGetUniformLocation(shader.Program, "fxaaEnabled"), fxaa ? 1 : 0);
+			glUniform2f(glGetUniformLocation(shader.Program, "sourceScale"), source.viewWidth * texelX, source.viewHeight * texelY);
+			glUniform2f(glGetUniformLocation(shader.Program, "texelSize"), texelX, texelY);
+			glUniform2f(glGetUniformLocation(shader.Program, "sourceMax"), (source.viewWidth - 0.5f) * texelX, (source.viewHeight - 0.5f) * texelY);
+
+			glActiveTexture(GL_TEXTURE0);
+			glBindTexture(GL_TEXTURE_2D, source.Texture());
+
+			glBindVertexArray(VAO);
+			glDrawArrays(GL_TRIANGLES, 0, 3);
+			glBindVertexArray(0);
+
+			glBindTexture(GL_TEXTURE_2D, 0);
+
+		glUseProgram(0);
+
+		if (depthTest) glEnable(GL_DEPTH_TEST);
+		if (blend) glEnable(GL_BLEND);
+	}
+};
\ No newline at end of file
@@ -0,0 +1,124 @@
+#pragma once
+
+#include "3d_shapes.h"
+#include "camera.hpp"
+#include "profiler.hpp"
+#include "mesh_object.hpp"
+
+// shapes evaluated by proceduralVert.glsl from gl_VertexID, nothing but a few uniforms is stored per shape
+// the vertex array stays empty, the core profile only needs one bound to draw
+// every corner is computed on its own, so the vertex shader runs six times per vertex instead of once,
+// in exchange for no memory and resolution changes that cost nothing
+class ProceduralShape : public MeshObject {
+protected:
+	enum ShapeType { DISK = 0, SPHERE = 1, TORUS = 2, TREFOIL = 3 };
+
+	GLint	shapeType;
+	GLint	divisions[2];
+	GLfloat radii[2];
+
+	ProceduralShape(ShapeType type, glm::vec3 position) : MeshObject(0, 0, 6) {
+		this->shapeType = type;
+		this->position	= position;
+
+		divisions[0] = divisions[1] = 0;
+		radii[0] = radii[1] = 0.0f;
+	}
+
+public:
+	void Draw(Camera camera, GLenum polygonMode = GL_FILL, GLenum drawMode = GL_TRIANGLES) override {
+		PROFILE_SCOPE("ProceduralShape::Draw");
+
+		SetMats(camera);
+
+		glPolygonMode(GL_FRONT_AND_BACK, polygonMode);
+
+		glBindVertexArray(this->VAO);
+		glUseProgram(this->shaderProgram);
+
+			glUniform1i(glGetUniformLocation(shaderProgram, "shapeType"), shapeType);
+			glUniform2i(glGetUniformLocation(shaderProgram, "divisions"), divisions[0], divisions[1]);
+			glUniform2f(glGetUniformLocation(shaderProgram, "radii"), radii[0], radii[1]);
+			glUniform3f(glGetUniformLocation(shaderProgram, "shapePosition"), position.x, position.y, position.z);
+
+			glDrawArrays(drawMode, 0, 3 * this->triCount);
+
+		glUseProgram(0);
+		glBindVertexArray(0);
+	}
+};
+
+class ProceduralDisk : public ProceduralShape {
+public:
+	ProceduralDisk(GLfloat radius = 1.0f, GLuint resolution = 16, glm::vec3 cPos = glm::vec3(0.0f, 0.0f, 0.0f)) : ProceduralShape(DISK, cPos) {
+		radii[0] = radius;
+
+		boundsMin = cPos - glm::vec3(radius, radius, 0.0f);
+		boundsMax = cPos + glm::vec3(radius, radius, 0.0f);
+
+		SetResolution(resolution);
+	}
+
+	void SetResolution(GLuint resolution) {
+		divisions[0] = resolution;
+		triCount	 = resolution;
+	}
+};
+
+class ProceduralSphere : public ProceduralShape {
+public:
+	ProceduralSphere(GLfloat radius = 1.0f, glm::vec3 position = glm::vec3(0.0f, 0.0f, 0.0f), GLuint divX = 16, GLuint divY = 16) : ProceduralShape(SPHERE, position) {
+		radii[0] = radius;
+
+		boundsMin = position - glm::vec3(radius);
+		boundsMax = position + glm::vec3(radius);
+
+		SetResolution(divX, divY);
+	}
+
+	void SetResolution(GLuint divX, GLuint divY) {
+		divisions[0] = divX;
+		divisions[1] = divY;
+		triCount	 = 2 * divX * divY;
+	}
+};
+
+class ProceduralTorus : public ProceduralShape {
+public:
+	ProceduralTorus(glm::vec3 position = glm::vec3(0.0f, 0.0f, 0.0f), GLfloat innerR = 0.5f, GLfloat outerR = 1.0f, GLuint divR = 8, GLuint divT = 32) : ProceduralShape(TORUS, position) {
+		radii[0] = innerR;
+		radii[1] = outerR;
+
+		boundsMin = position - glm::vec3(outerR + innerR, outerR + innerR, innerR);
+		boundsMax = position + glm::vec3(outerR + innerR, outerR + innerR, innerR);
+
+		SetResolution(divR, divT);
+	}
+
+	void SetResolution(GLuint divR, GLuint divT) {
+		divisions[0] = divR;
+		divisions[1] = divT;
+		triCount	 = 2 * divR * divT;
+	}
+};
+
+class ProceduralTrefoil : public ProceduralShape {
+public:
+	ProceduralTrefoil(glm::vec3 position, GLuint divL, GLuint divN, GLfloat radN = 0.125f, GLfloat radT = 1.0f) : ProceduralShape(TREFOIL, position) {
+		radii[0] = radN;
+		radii[1] = radT;
+
+		// the curve stays within 0.99 radT in x and y and 0.33 radT in z
+		glm::vec3 extent(0.99f * radT + radN, 0.99f * radT + radN, 0.33f * radT + radN);
+		boundsMin = position - extent;
+		boundsMax = position + extent;
+
+		SetResolution(divL, divN);
+	}
+
+	void SetResolution(GLuint divL, GLuint divN) {
+		divisions[0] = divL;
+		divisions[1] = divN;
+		triCount	 = 2 * divL * divN;
+	}
+};
\ No newline at end of file
@@ -0,0 +1,406 @@
+#pragma once
+
+#include "3d_shapes.h"
+
+// the profiler is compiled in for debug builds, define ENABLE_PROFILER to keep it in release builds
+#if !defined(NDEBUG) || defined(ENABLE_PROFILER)
+#define PROFILER_ENABLED 1
+#else
+#define PROFILER_ENABLED 0
+#endif
+
+#if PROFILER_ENABLED
+
+#include "shader.hpp"
+#include "text_overlay.hpp"
+
+#include <chrono>
+#include <cstdio>
+#include <deque>
+#include <fstream>
+#include <memory>
+#include <string>
+
+#define PROFILE_CONCAT_INNER(a, b) a##b
+#define PROFILE_CONCAT(a, b) PROFILE_CONCAT_INNER(a, b)
+
+// times the enclosing scope on the cpu and on the gpu, name must be a string literal
+#define PROFILE_SCOPE(name) ProfileScope PROFILE_CONCAT(profileScope_, __LINE__)(name)
+
+#define PROFILE_BEGIN_FRAME() Profiler::Get().BeginFrame()
+#define PROFILE_END_FRAME() Profiler::Get().EndFrame()
+#define PROFILE_DRAW_OVERLAY(width, height) Profiler::Get().DrawOverlay(width, height)
+#define PROFILE_TOGGLE_OVERLAY() Profiler::Get().ToggleOverlay()
+#define PROFILE_DUMP_TRACE(path) Profiler::Get().DumpChromeTrace(path)
+#define PROFILE_SHUTDOWN() Profiler::Get().Shutdown()
+
+// RAII timer behind PROFILE_SCOPE
+class ProfileScope {
+private:
+	GLint zone;
+
+public:
+	ProfileScope(const char* name);
+	~ProfileScope();
+
+	ProfileScope(const ProfileScope&) = delete;
+	ProfileScope& operator=(const ProfileScope&) = delete;
+};
+
+// one node of the aggregated profile, scopes with the same name under the same parent are merged
+struct ProfileNode {
+	const char* name;
+
+	GLuint depth;
+	GLuint calls;
+
+	GLdouble cpuMs;
+	GLdouble gpuMs;
+};
+
+class Profiler {
+private:
+	struct Zone {
+		const char* name;
+
+		GLint  parent;
+		GLuint depth;
+
+		GLdouble cpuBegin;	// microseconds since the profiler started
+		GLdouble cpuEnd;
+
+		GLuint queryBegin;	// indices into the frame's query pool
+		GLuint queryEnd;
+	};
+
+	// gpu results are read back when the slot comes around again, so two frames are kept in flight
+	struct FrameSlot {
+		std::vector <Zone>	 zones;
+		std::vector <GLuint> queries;
+
+		GLuint	  queriesUsed = 0;
+		GLboolean pending	  = GL_FALSE;
+	};
+
+	struct TraceEvent {
+		const char* name;
+
+		GLuint	 thread;	// 0 for cpu, 1 for gpu
+		GLdouble begin;		// microseconds
+		GLdouble duration;
+	};
+
+	static constexpr GLuint FRAME_SLOTS		  = 2;
+	static constexpr size_t MAX_TRACE_EVENTS  = 100000;
+
+	FrameSlot slots[FRAME_SLOTS];
+	GLuint	  frameIndex;
+	GLint	  openZone;
+
+	GLboolean initialized;
+	GLboolean inFrame;
+
+	// zones are only recorded on the thread that begins the frames, scopes on other threads are ignored
+	static GLboolean& FrameThread() {
+		thread_local GLboolean frameThread = GL_FALSE;
+		return frameThread;
+	}
+
+	std::chrono::steady_clock::time_point startTime;
+	GLdouble gpuOffset;		// cpu time minus gpu time, in microseconds
+
+	std::deque <TraceEvent> trace;
+
+	std::unique_ptr <Shader>	  overlayShader;
+	std::unique_ptr <TextOverlay> overlay;
+
+	Profiler() {
+		frameIndex	= 0;
+		openZone	= -1;
+		initialized = GL_FALSE;
+		inFrame		= GL_FALSE;
+		gpuOffset	= 0.0;
+
+		showOverlay = GL_TRUE;
+		frameMs		= 0.0;
+	}
+
+	GLdouble Now() const {
+		return std::chrono::duration<GLdouble, std::micro>(std::chrono::steady_clock::now() - startTime).count();
+	}
+
+	GLuint NextQuery(FrameSlot& slot) {
+		if (slot.queriesUsed == slot.queries.size()) {
+			GLuint query;
+			glGenQueries(1, &query);
+			slot.queries.push_back(query);
+		}
+
+		return slot.queriesUsed++;
+	}
+
+	void Initialize() {
+		startTime = std::chrono::steady_clock::now();
+
+		// line up gpu timestamps with the cpu clock for the trace
+		GLint64 gpuNow = 0;
+		glGetInteger64v(GL_TIMESTAMP, &gpuNow);
+		gpuOffset = Now() - gpuNow / 1000.0;
+
+		initialized = GL_TRUE;
+	}
+
+	void AddTraceEvent(const char* name, GLuint thread, GLdouble begin, GLdouble duration) {
+		if (trace.size() == MAX_TRACE_EVENTS) trace.pop_front();
+
+		trace.push_back({ name, thread, begin, duration });
+	}
+
+	// reads back a finished frame and merges its zones into the hierarchical profile
+	void Resolve(FrameSlot& slot) {
+		if (!slot.pending) { return; }
+
+		// never stall, if the gpu is more than a frame behind the results are dropped
+		if (slot.queriesUsed > 0) {
+			GLint available = 0;
+			glGetQueryObjectiv(slot.queries[slot.queriesUsed - 1], GL_QUERY_RESULT_AVAILABLE, &available);
+
+			if (!available) {
+				slot.pending = GL_FALSE;
+				return;
+			}
+		}
+
+		std::vector <GLuint64> timestamps(slot.queriesUsed);
+		for (GLuint i = 0; i < slot.queriesUsed; i++) {
+			glGetQueryObjectui64v(slot.queries[i], GL_QUERY_RESULT, &timestamps[i]);
+		}
+
+		// children of each node in order of first appearance, node -1 is the frame itself
+		std::vector <ProfileNode> nodes;
+		std::vector <std::vector <GLuint>> children(1);
+		std::vector <GLint> zoneNode(slot.zones.size());
+
+		for (size_t i = 0; i < slot.zones.size(); i++) {
+			const Zone& zone = slot.zones[i];
+
+			GLint parentNode = (zone.parent == -1) ? -1 : zoneNode[zone.parent];
+			GLint node = -1;
+			for (GLuint sibling : children[parentNode + 1]) {
+				if (std::string(nodes[sibling].name) == zone.name) {
+					node = sibling;
+					break;
+				}
+			}
+
+			if (node == -1) {
+				node = (GLint)nodes.size();
+				nodes.push_back({ zone.name, zone.depth, 0, 0.0, 0.0 });
+				children.emplace_back();
+				children[parentNode + 1].push_back(node);
+			}
+
+			GLdouble gpuBegin = timestamps[zone.queryBegin] / 1000.0 + gpuOffset;
+			GLdouble gpuTime  = (timestamps[zone.queryEnd] - timestamps[zone.queryBegin]) / 1000.0;
+
+			nodes[node].calls++;
+			nodes[node].cpuMs += (zone.cpuEnd - zone.cpuBegin) / 1000.0;
+			nodes[node].gpuMs += gpuTime / 1000.0;
+			zoneNode[i] = node;
+
+			AddTraceEvent(zone.name, 0, zone.cpuBegin, zone.cpuEnd - zone.cpuBegin);
+			AddTraceEvent(zone.name, 1, gpuBegin, gpuTime);
+		}
+
+		// flatten depth first so the overlay can print the tree top to bottom
+		profile.clear();
+
+		std::vector <GLuint> stack(children[0].rbegin(), children[0].rend());
+		while (!stack.empty()) {
+			GLuint node = stack.back();
+			stack.pop_back();
+
+			profile.push_back(nodes[node]);
+			stack.insert(stack.end(), children[node + 1].rbegin(), children[node + 1].rend());
+		}
+
+		slot.pending = GL_FALSE;
+	}
+
+public:
+	std::vector <ProfileNode> profile;
+
+	GLboolean showOverlay;
+	GLdouble  frameMs;
+
+	static Profiler& Get() {
+		static Profiler instance;
+		return instance;
+	}
+
+	Profiler(const Profiler&) = delete;
+	Profiler& operator=(const Profiler&) = delete;
+
+	GLint BeginZone(const char* name) {
+		if (!FrameThread() || !inFrame) { return -1; }
+
+		FrameSlot& slot = slots[frameIndex % FRAME_SLOTS];
+
+		Zone zone;
+		zone.name		= name;
+		zone.parent		= openZone;
+		zone.depth		= (openZone == -1) ? 0 : slot.zones[openZone].depth + 1;
+		zone.queryBegin = NextQuery(slot);
+		zone.queryEnd	= NextQuery(slot);
+		zone.cpuEnd		= 0.0;
+
+		// GL_TIME_ELAPSED queries cannot nest, a pair of timestamps can
+		glQueryCounter(slot.queries[zone.queryBegin], GL_TIMESTAMP);
+		zone.cpuBegin = Now();
+
+		openZone = (GLint)slot.zones.size();
+		slot.zones.push_back(zone);
+
+		return openZone;
+	}
+
+	void EndZone(GLint index) {
+		if (!FrameThread() || !inFrame || index == -1) { return; }
+
+		FrameSlot& slot = slots[frameIndex % FRAME_SLOTS];
+		Zone& zone = slot.zones[index];
+
+		zone.cpuEnd = Now();
+		glQueryCounter(slot.queries[zone.queryEnd], GL_TIMESTAMP);
+
+		openZone = zone.parent;
+	}
+
+	void BeginFrame() {
+		if (!initialized) Initialize();
+
+		// this slot was last used two frames ago, its queries are most likely done by now
+		FrameSlot& slot = slots[frameIndex % FRAME_SLOTS];
+		Resolve(slot);
+
+		slot.zones.clear();
+		slot.queriesUsed = 0;
+
+		openZone = -1;
+		inFrame	 = GL_TRUE;
+
+		FrameThread() = GL_TRUE;
+
+		BeginZone("frame");
+	}
+
+	void EndFrame() {
+		if (!inFrame) { return; }
+
+		FrameSlot& slot = slots[frameIndex % FRAME_SLOTS];
+
+		EndZone(0);
+		frameMs = (slot.zones[0].cpuEnd - slot.zones[0].cpuBegin) / 1000.0;
+
+		slot.pending = GL_TRUE;
+		inFrame = GL_FALSE;
+		frameIndex++;
+	}
+
+	void ToggleOverlay() {
+		showOverlay = !showOverlay;
+	}
+
+	void DrawOverlay(GLint width, GLint height) {
+		if (!showOverlay) { return; }
+
+		PROFILE_SCOPE("overlay");
+
+		if (!overlay) {
+			overlayShader.reset(new Shader("./shaders/overlayVert.glsl", "./shaders/solidColorFrag.glsl"));
+			overlay.reset(new TextOverlay(2.0f));
+			overlay->SetShader(overlayShader->Program);
+		}
+
+		char line[128];
+		GLfloat y = 8.0f;
+
+		std::snprintf(line, sizeof(line), "%-28s %5s %8s %8s", "scope", "calls", "cpu ms", "gpu ms");
+		overlay->Print(8.0f, y, line);
+		y += 14.0f;
+
+		for (const ProfileNode& node : profile) {
+			std::string name = std::string(2 * node.depth, ' ') + node.name;
+
+			std::snprintf(line, sizeof(line), "%-28.28s %5u %8.3f %8.3f", name.c_str(), node.calls, node.cpuMs, node.gpuMs);
+			overlay->Print(8.0f, y, line);
+			y += 14.0f;
+		}
+
+		overlay->Draw(width, height, glm::vec4(1.0f, 0.85f, 0.2f, 1.0f));
+	}
+
+	// releases the gl objects, has to run while the context is still alive
+	void Shutdown() {
+		for (FrameSlot& slot : slots) {
+			if (!slot.queries.empty()) glDeleteQueries((GLsizei)slot.queries.size(), slot.queries.data());
+
+			slot.queries.clear();
+			slot.zones.clear();
+			slot.queriesUsed = 0;
+			slot.pending = GL_FALSE;
+		}
+
+		// the shader's program handle deletes the program
+		overlay.reset();
+		overlayShader.reset();
+	}
+
+	// writes the recorded zones in the chrome://tracing / perfetto json format
+	GLboolean DumpChromeTrace(const char* path) {
+		std::ofstream file(path);
+
+		if (!file.is_open()) {
+			std::cout << "ERROR::PROFILER::CANNOT_OPEN_TRACE_FILE\n";
+			std::cout << path << std::endl;
+
+			return GL_FALSE;
+		}
+
+		file << "{\"traceEvents\":[\n";
+		file << "{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":0,\"tid\":0,\"args\":{\"name\":\"CPU\"}},\n";
+		file << "{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":0,\"tid\":1,\"args\":{\"name\":\"GPU\"}}";
+
+		char event[256];
+		for (const TraceEvent& e : trace) {
+			std::snprintf(event, sizeof(event), ",\n{\"name\":\"%s\",\"ph\":\"X\",\"pid\":0,\"tid\":%u,\"ts\":%.3f,\"dur\":%.3f}",
+				e.name, e.thread, e.begin, e.duration);
+			file << event;
+		}
+
+		file << "\n]}\n";
+
+		std::cout << "profiler: wrote " << trace.size() << " events to " << path << std::endl;
+		return GL_TRUE;
+	}
+};
+
+inline ProfileScope::ProfileScope(const char* name) {
+	zone = Profiler::Get().BeginZone(name);
+}
+
+inline ProfileScope::~ProfileScope() {
+	Profiler::Get().EndZone(zone);
+}
+
+#else
+
+#define PROFILE_SCOPE(name)
+#define PROFILE_BEGIN_FRAME()
+#define PROFILE_END_FRAME()
+#define PROFILE_DRAW_OVERLAY(width, height)
+#define PROFILE_TOGGLE_OVERLAY()
+#define PROFILE_DUMP_TRACE(path)
+#define PROFILE_SHUTDOWN()
+
+#endif
\ No newline at end of file
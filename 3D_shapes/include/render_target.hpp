@@ -0,0 +1,167 @@
+#pragma once
+
+#include "3d_shapes.h"
+
+#include <algorithm>
+#include <iostream>
+
+// offscreen framebuffer the scene is drawn into, multisampled targets are resolved into a plain texture
+class RenderTarget {
+private:
+	GLuint FBO;
+	GLuint colorBuffer;		// renderbuffer when multisampled, otherwise the resolve texture itself
+	GLuint depthBuffer;
+
+	GLuint resolveFBO;
+	GLuint resolveTexture;
+
+	void Release() {
+		if (resolveFBO != FBO) glDeleteFramebuffers(1, &resolveFBO);
+		glDeleteFramebuffers(1, &FBO);
+
+		if (samples > 1) glDeleteRenderbuffers(1, &colorBuffer);
+		glDeleteRenderbuffers(1, &depthBuffer);
+		glDeleteTextures(1, &resolveTexture);
+
+		FBO = resolveFBO = colorBuffer = depthBuffer = resolveTexture = 0;
+	}
+
+	void Create() {
+		// single sample color texture, read back by captures and sampled by post processing
+		glGenTextures(1, &resolveTexture);
+		glBindTexture(GL_TEXTURE_2D, resolveTexture);
+		glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA8, width, height, 0, GL_RGBA, GL_UNSIGNED_BYTE, nullptr);
+		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+		glBindTexture(GL_TEXTURE_2D, 0);
+
+		glGenFramebuffers(1, &FBO);
+		glBindFramebuffer(GL_FRAMEBUFFER, FBO);
+
+		glGenRenderbuffers(1, &depthBuffer);
+		glBindRenderbuffer(GL_RENDERBUFFER, depthBuffer);
+
+		if (samples > 1) {
+			glRenderbufferStorageMultisample(GL_RENDERBUFFER, samples, GL_DEPTH24_STENCIL8, width, height);
+
+			glGenRenderbuffers(1, &colorBuffer);
+			glBindRenderbuffer(GL_RENDERBUFFER, colorBuffer);
+			glRenderbufferStorageMultisample(GL_RENDERBUFFER, samples, GL_RGBA8, width, height);
+
+			glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_RENDERBUFFER, colorBuffer);
+		}
+		else {
+			glRenderbufferStorage(GL_RENDERBUFFER, GL_DEPTH24_STENCIL8, width, height);
+
+			colorBuffer = resolveTexture;
+			glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, resolveTexture, 0);
+		}
+
+		glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_DEPTH_STENCIL_ATTACHMENT, GL_RENDERBUFFER, depthBuffer);
+		glBindRenderbuffer(GL_RENDERBUFFER, 0);
+
+		if (glCheckFramebufferStatus(GL_FRAMEBUFFER) != GL_FRAMEBUFFER_COMPLETE) {
+			std::cout << "ERROR::RENDER_TARGET::INCOMPLETE_FRAMEBUFFER" << std::endl;
+		}
+
+		resolveFBO = FBO;
+
+		if (samples > 1) {
+			glGenFramebuffers(1, &resolveFBO);
+			glBindFramebuffer(GL_FRAMEBUFFER, resolveFBO);
+			glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, resolveTexture, 0);
+
+			if (glCheckFramebufferStatus(GL_FRAMEBUFFER) != GL_FRAMEBUFFER_COMPLETE) {
+				std::cout << "ERROR::RENDER_TARGET::INCOMPLETE_RESOLVE_FRAMEBUFFER" << std::endl;
+			}
+		}
+
+		glBindFramebuffer(GL_FRAMEBUFFER, 0);
+	}
+
+public:
+	GLint  width;
+	GLint  height;
+	GLuint samples;
+
+	// the corner of the target that is drawn, resolved and blitted, all of it unless SetViewSize shrank it
+	GLint viewWidth;
+	GLint viewHeight;
+
+	RenderTarget(GLint width, GLint height, GLuint samples = 1) {
+		this->width	  = (width > 0) ? width : 1;
+		this->height  = (height > 0) ? height : 1;
+		this->samples = samples;
+
+		viewWidth  = this->width;
+		viewHeight = this->height;
+
+		Create();
+	}
+
+	RenderTarget(const RenderTarget&) = delete;
+	RenderTarget& operator=(const RenderTarget&) = delete;
+
+	void Resize(GLint width, GLint height) {
+		if (width <= 0 || height <= 0 || (width == this->width && height == this->height)) { return; }
+
+		this->width	 = width;
+		this->height = height;
+
+		viewWidth  = width;
+		viewHeight = height;
+
+		Release();
+		Create();
+	}
+
+	// renders into part of the target without reallocating it, for dynamic resolution
+	void SetViewSize(GLint width, GLint height) {
+		viewWidth  = std::clamp(width, 1, this->width);
+		viewHeight = std::clamp(height, 1, this->height);
+	}
+
+	// subsequent draws go to this target
+	void Bind() {
+		glBindFramebuffer(GL_FRAMEBUFFER, FBO);
+		glViewport(0, 0, viewWidth, viewHeight);
+	}
+
+	// makes the resolve texture current and returns the framebuffer it is attached to
+	GLuint Resolve() {
+		if (samples > 1) {
+			glBindFramebuffer(GL_READ_FRAMEBUFFER, FBO);
+			glBindFramebuffer(GL_DRAW_FRAMEBUFFER, resolveFBO);
+			glBlitFramebuffer(0, 0, viewWidth, viewHeight, 0, 0, viewWidth, viewHeight, GL_COLOR_BUFFER_BIT, GL_NEAREST);
+		}
+
+		glBindFramebuffer(GL_FRAMEBUFFER, 0);
+		return resolveFBO;
+	}
+
+	// copies the resolved image to the window, scaling it if the sizes differ
+	void BlitToScreen(GLint screenWidth, GLint screenHeight) {
+		glBindFramebuffer(GL_READ_FRAMEBUFFER, resolveFBO);
+		glBindFramebuffer(GL_DRAW_FRAMEBUFFER, 0);
+
+		GLenum filter = (screenWidth == viewWidth && screenHeight == viewHeight) ? GL_NEAREST : GL_LINEAR;
+		glBlitFramebuffer(0, 0, viewWidth, viewHeight, 0, 0, screenWidth, screenHeight, GL_COLOR_BUFFER_BIT, filter);
+
+		glBindFramebuffer(GL_FRAMEBUFFER, 0);
+		glViewport(0, 0, screenWidth, screenHeight);
+	}
+
+	GLuint Texture() const {
+		return resolveTexture;
+	}
+
+	GLuint ResolvedFramebuffer() const {
+		return resolveFBO;
+	}
+
+	~RenderTarget() {
+		Release();
+	}
+};
\ No newline at end of file
@@ -0,0 +1,106 @@
+#pragma once
+
+#include "3d_shapes.h"
+#include "frame_packet.hpp"
+
+#include <condition_variable>
+#include <functional>
+#include <mutex>
+#include <thread>
+
+// owns the gl context and draws every packet the update thread submits, on a thread of its own
+// packets go through a queue one frame deep with a slot for each side: the update thread builds frame n + 1
+// while frame n is drawn, and waits in Packet when it gets further ahead than that
+// no packet is ever dropped, so captures get every frame and vsync on the render thread paces the update thread
+class RenderThread {
+private:
+	FramePacket packets[2];
+
+	std::thread				thread;
+	std::mutex				mutex;
+	std::condition_variable wake;
+
+	GLuint64  submitted;
+	GLuint64  taken;
+	GLboolean stopping;
+
+	void Loop(GLFWwindow* window, std::function <void(const FramePacket&)> render) {
+		glfwMakeContextCurrent(window);
+
+		while (true) {
+			GLuint64 frame;
+
+			{
+				std::unique_lock <std::mutex> lock(mutex);
+				wake.wait(lock, [this]() { return stopping || submitted > taken; });
+
+				if (submitted == taken) { break; }
+
+				frame = taken++;
+			}
+
+			// the update thread may start filling the other slot now
+			wake.notify_all();
+
+			const FramePacket& packet = packets[frame % 2];
+
+			render(packet);
+			latency.Add(packet);
+		}
+
+		glfwMakeContextCurrent(nullptr);
+	}
+
+public:
+	// written by the render thread, read them after Stop
+	LatencyStats latency;
+
+	RenderThread() {
+		submitted = 0;
+		taken	  = 0;
+		stopping  = GL_FALSE;
+	}
+
+	RenderThread(const RenderThread&) = delete;
+	RenderThread& operator=(const RenderThread&) = delete;
+
+	// the context must not be current on the calling thread anymore
+	void Start(GLFWwindow* window, std::function <void(const FramePacket&)> render) {
+		thread = std::thread(&RenderThread::Loop, this, window, std::move(render));
+	}
+
+	// the packet to fill for the next Submit, once the render thread has moved on to the previous one
+	// it still holds the contents from two submits ago, so its memory can be reused
+	FramePacket& Packet() {
+		std::unique_lock <std::mutex> lock(mutex);
+		wake.wait(lock, [this]() { return taken == submitted; });
+
+		return packets[submitted % 2];
+	}
+
+	void Submit() {
+		{
+			std::lock_guard <std::mutex> lock(mutex);
+			submitted++;
+		}
+
+		wake.notify_all();
+	}
+
+	// draws whatever was submitted and joins, the context can be made current on the caller again afterwards
+	void Stop() {
+		if (!thread.joinable()) { return; }
+
+		{
+			std::lock_guard <std::mutex> lock(mutex);
+			stopping = GL_TRUE;
+		}
+
+		wake.notify_all();
+		thread.join();
+	}
+
+	~RenderThread() {
+		Stop();
+	}
+};
\ No newline at end of file
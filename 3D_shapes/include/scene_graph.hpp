@@ -0,0 +1,259 @@
+#pragma once
+
+#include "3d_shapes.h"
+#include "profiler.hpp"
+
+#include <algorithm>
+#include <cstdint>
+#include <iostream>
+#include <vector>
+
+// handle to a node, stays valid when the graph reorders its arrays
+typedef GLuint SceneNode;
+
+constexpr SceneNode NO_SCENE_NODE = ~0u;
+
+// transform hierarchy stored as structure of arrays in topological order, every parent sits before its children
+// Update walks the arrays once from front to back and only recomputes world matrices below a changed node
+class SceneGraph {
+private:
+	// indexed by slot, the position of a node in topological order
+	std::vector <GLint>		parents;		// slot of the parent, -1 for roots
+	std::vector <glm::vec3> translations;
+	std::vector <glm::quat> rotations;
+	std::vector <glm::vec3> scales;
+	std::vector <glm::mat4> worlds;
+	std::vector <uint8_t>	dirty;
+	std::vector <SceneNode> owners;			// node stored in each slot
+
+	std::vector <GLuint> slots;				// indexed by node
+	GLboolean orderChanged;
+
+	// local matrix straight from translation, rotation and scale, without the three full products glm::translate etc. do
+	static glm::mat4 Compose(const glm::vec3& translation, const glm::quat& rotation, const glm::vec3& scale) {
+		glm::mat3 basis = glm::mat3_cast(rotation);
+
+		return glm::mat4(
+			glm::vec4(basis[0] * scale.x, 0.0f),
+			glm::vec4(basis[1] * scale.y, 0.0f),
+			glm::vec4(basis[2] * scale.z, 0.0f),
+			glm::vec4(translation, 1.0f)
+		);
+	}
+
+	// both matrices have 0 0 0 1 as last row, which skips a quarter of a full product
+	// every column is three or four 4 wide multiply adds
+	static glm::mat4 AffineMultiply(const glm::mat4& a, const glm::mat4& b) {
+		glm::mat4 result;
+
+		result[0] = a[0] * b[0].x + a[1] * b[0].y + a[2] * b[0].z;
+		result[1] = a[0] * b[1].x + a[1] * b[1].y + a[2] * b[1].z;
+		result[2] = a[0] * b[2].x + a[1] * b[2].y + a[2] * b[2].z;
+		result[3] = a[0] * b[3].x + a[1] * b[3].y + a[2] * b[3].z + a[3];
+
+		return result;
+	}
+
+	GLboolean IsDescendant(SceneNode node, SceneNode ancestor) const {
+		for (GLint slot = (GLint)slots[node]; slot >= 0; slot = parents[slot]) {
+			if (owners[slot] == ancestor) { return GL_TRUE; }
+		}
+
+		return GL_FALSE;
+	}
+
+	// restores topological order after a node was moved below one that came after it
+	// depth first from the roots, which keeps subtrees contiguous and siblings in their old order
+	void Reorder() {
+		PROFILE_SCOPE("SceneGraph::Reorder");
+
+		GLuint count = (GLuint)parents.size();
+
+		// children as ranges of one array, counting sort by parent
+		std::vector <GLuint> childStart(count + 2, 0);
+		std::vector <GLuint> children(count);
+
+		for (GLuint slot = 0; slot < count; slot++) childStart[parents[slot] + 2]++;
+		for (GLuint i = 2; i < count + 2; i++) childStart[i] += childStart[i - 1];
+		for (GLuint slot = 0; slot < count; slot++) children[childStart[parents[slot] + 1]++] = slot;
+
+		// the placement shifted every start to the end of its range, the children of slot s are now
+		// childStart[s] up to childStart[s + 1] and the roots 0 up to childStart[0]
+		std::vector <GLuint> order;
+		std::vector <GLuint> stack;
+		order.reserve(count);
+
+		for (GLuint i = 0; i < childStart[0]; i++) {
+			stack.push_back(children[i]);
+
+			while (!stack.empty()) {
+				GLuint slot = stack.back();
+				stack.pop_back();
+				order.push_back(slot);
+
+				for (GLuint j = childStart[slot + 1]; j > childStart[slot]; j--) stack.push_back(children[j - 1]);
+			}
+		}
+
+		std::vector <GLuint> newSlot(count);
+		for (GLuint i = 0; i < count; i++) newSlot[order[i]] = i;
+
+		std::vector <GLint>		newParents(count);
+		std::vector <glm::vec3> newTranslations(count);
+		std::vector <glm::quat> newRotations(count);
+		std::vector <glm::vec3> newScales(count);
+		std::vector <glm::mat4> newWorlds(count);
+		std::vector <uint8_t>	newDirty(count);
+		std::vector <SceneNode> newOwners(count);
+
+		for (GLuint i = 0; i < count; i++) {
+			GLuint slot = order[i];
+
+			newParents[i]	   = (parents[slot] < 0) ? -1 : (GLint)newSlot[parents[slot]];
+			newTranslations[i] = translations[slot];
+			newRotations[i]	   = rotations[slot];
+			newScales[i]	   = scales[slot];
+			newWorlds[i]	   = worlds[slot];
+			newDirty[i]		   = dirty[slot];
+			newOwners[i]	   = owners[slot];
+
+			slots[owners[slot]] = i;
+		}
+
+		parents.swap(newParents);
+		translations.swap(newTranslations);
+		rotations.swap(newRotations);
+		scales.swap(newScales);
+		worlds.swap(newWorlds);
+		dirty.swap(newDirty);
+		owners.swap(newOwners);
+
+		orderChanged = GL_FALSE;
+	}
+
+public:
+	// world matrices recomputed by the last Update
+	GLuint updatedCount;
+
+	SceneGraph() {
+		orderChanged = GL_FALSE;
+		updatedCount = 0;
+	}
+
+	void Reserve(GLuint count) {
+		parents.reserve(count);
+		translations.reserve(count);
+		rotations.reserve(count);
+		scales.reserve(count);
+		worlds.reserve(count);
+		dirty.reserve(count);
+		owners.reserve(count);
+		slots.reserve(count);
+	}
+
+	// appending keeps the order topological, the parent already exists
+	SceneNode Create(SceneNode parent = NO_SCENE_NODE, glm::vec3 translation = glm::vec3(0.0f), glm::quat rotation = glm::quat(1.0f, 0.0f, 0.0f, 0.0f), glm::vec3 scale = glm::vec3(1.0f)) {
+		SceneNode node = (SceneNode)slots.size();
+
+		slots.push_back((GLuint)parents.size());
+		owners.push_back(node);
+
+		parents.push_back((parent == NO_SCENE_NODE) ? -1 : (GLint)slots[parent]);
+		translations.push_back(translation);
+		rotations.push_back(rotation);
+		scales.push_back(scale);
+		worlds.push_back(glm::mat4(1.0f));
+		dirty.push_back(1);
+
+		return node;
+	}
+
+	// moves node and its subtree below parent, or makes it a root with NO_SCENE_NODE
+	void SetParent(SceneNode node, SceneNode parent) {
+		if (parent != NO_SCENE_NODE && IsDescendant(parent, node)) {
+			std::cout << "ERROR::SCENE_GRAPH::PARENT_IS_DESCENDANT" << std::endl;
+			return;
+		}
+
+		GLuint slot = slots[node];
+
+		parents[slot] = (parent == NO_SCENE_NODE) ? -1 : (GLint)slots[parent];
+		dirty[slot]	  = 1;
+
+		if (parent != NO_SCENE_NODE && slots[parent] > slot) orderChanged = GL_TRUE;
+	}
+
+	void SetTranslation(SceneNode node, glm::vec3 translation) {
+		translations[slots[node]] = translation;
+		dirty[slots[node]] = 1;
+	}
+
+	void SetRotation(SceneNode node, glm::quat rotation) {
+		rotations[slots[node]] = rotation;
+		dirty[slots[node]] = 1;
+	}
+
+	void SetScale(SceneNode node, glm::vec3 scale) {
+		scales[slots[node]] = scale;
+		dirty[slots[node]] = 1;
+	}
+
+	void Translate(SceneNode node, glm::vec3 offset) {
+		translations[slots[node]] += offset;
+		dirty[slots[node]] = 1;
+	}
+
+	// angle in radians around a local axis, the same convention as MeshObject::Rotate
+	void Rotate(SceneNode node, glm::vec3 axis, GLfloat angle) {
+		glm::quat& rotation = rotations[slots[node]];
+
+		rotation = glm::normalize(rotation * glm::angleAxis(angle, glm::normalize(axis)));
+		dirty[slots[node]] = 1;
+	}
+
+	glm::vec3 Translation(SceneNode node) const { return translations[slots[node]]; }
+	glm::quat Rotation(SceneNode node) const { return rotations[slots[node]]; }
+	glm::vec3 Scale(SceneNode node) const { return scales[slots[node]]; }
+
+	SceneNode Parent(SceneNode node) const {
+		GLint parent = parents[slots[node]];
+		return (parent < 0) ? NO_SCENE_NODE : owners[parent];
+	}
+
+	// valid after Update
+	const glm::mat4& World(SceneNode node) const {
+		return worlds[slots[node]];
+	}
+
+	GLuint Size() const {
+		return (GLuint)parents.size();
+	}
+
+	// one pass in slot order, a parent is finished before its children are reached
+	// so its dirty flag already tells them whether they have to follow
+	void Update() {
+		PROFILE_SCOPE("SceneGraph::Update");
+
+		if (orderChanged) Reorder();
+
+		GLuint count   = (GLuint)parents.size();
+		GLuint updated = 0;
+
+		const GLint* parent = parents.data();
+		uint8_t* flags = dirty.data();
+		glm::mat4* world = worlds.data();
+
+		for (GLuint i = 0; i < count; i++) {
+			if (parent[i] >= 0) flags[i] |= flags[parent[i]];
+			if (!flags[i]) continue;
+
+			glm::mat4 local = Compose(translations[i], rotations[i], scales[i]);
+			world[i] = (parent[i] >= 0) ? AffineMultiply(world[parent[i]], local) : local;
+
+			updated++;
+		}
+
+		std::fill(dirty.begin(), dirty.end(), 0);
+		updatedCount = updated;
+	}
+};
\ No newline at end of file
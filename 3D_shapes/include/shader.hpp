@@ -2,6 +2,7 @@
 #pragma warning (disable : 26495)
 
 #include "3d_shapes.h"
+#include "gl_resource.hpp"
 
 #include <iostream>
 #include <fstream>
@@ -9,7 +10,8 @@
 
 class Shader {
 public:
-	GLuint Program;
+	// deleted with the shader, converts to GLuint wherever a program name is expected
+	ProgramHandle Program;
 
 	Shader(const char* vertShaderPath, const char* fragShaderPath, const char* geoShaderPath = "") {
 		std::ifstream vertShaderSource, fragShaderSource, geoShaderSource;
@@ -123,7 +125,7 @@ public:
 		}
 
 		// linke the compiled shaders to the shader program
-		this->Program = glCreateProgram();
+		this->Program = ProgramHandle::Create();
 		glAttachShader(this->Program, vertexShader);
 		if (geoShaderPath != "") {
 			glAttachShader(this->Program, geoShader);
@@ -151,5 +153,6 @@ public:
 		// delete the shaders since they are not needed anymore, in this use case
 		glDeleteShader(vertexShader);
 		glDeleteShader(fragmentShader);
+		if (geoShader != 0) glDeleteShader(geoShader);
 	}
 };
\ No newline at end of file
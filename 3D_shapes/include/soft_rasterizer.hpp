@@ -0,0 +1,865 @@
+#pragma once
+
+#include "3d_shapes.h"
+#include "camera.hpp"
+#include "mesh_object.hpp"
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <cstring>
+#include <functional>
+#include <iostream>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define SOFT_RASTER_SSE2
+#include <emmintrin.h>
+#endif
+
+// four float lanes for the edge functions, sse2 where the compiler has it and plain arrays otherwise
+// comparisons return lanes with every bit set or cleared, like the sse2 instructions do
+struct Float4 {
+#ifdef SOFT_RASTER_SSE2
+	__m128 v;
+
+	Float4() : v(_mm_setzero_ps()) {}
+	Float4(__m128 v) : v(v) {}
+	Float4(GLfloat s) : v(_mm_set1_ps(s)) {}
+	Float4(GLfloat a, GLfloat b, GLfloat c, GLfloat d) : v(_mm_setr_ps(a, b, c, d)) {}
+
+	static Float4 Load(const GLfloat* p) { return _mm_loadu_ps(p); }
+	void Store(GLfloat* p) const { _mm_storeu_ps(p, v); }
+
+	// integer lanes carried through selects untouched
+	static Float4 Bits(GLuint s) { return _mm_castsi128_ps(_mm_set1_epi32((int)s)); }
+	static Float4 LoadBits(const GLuint* p) { return _mm_castsi128_ps(_mm_loadu_si128((const __m128i*)p)); }
+	static Float4 EqualBits(Float4 a, Float4 b) { return _mm_castsi128_ps(_mm_cmpeq_epi32(_mm_castps_si128(a.v), _mm_castps_si128(b.v))); }
+	void StoreBits(GLuint* p) const { _mm_storeu_si128((__m128i*)p, _mm_castps_si128(v)); }
+
+	friend Float4 operator+(Float4 a, Float4 b) { return _mm_add_ps(a.v, b.v); }
+	friend Float4 operator-(Float4 a, Float4 b) { return _mm_sub_ps(a.v, b.v); }
+	friend Float4 operator*(Float4 a, Float4 b) { return _mm_mul_ps(a.v, b.v); }
+	friend Float4 operator/(Float4 a, Float4 b) { return _mm_div_ps(a.v, b.v); }
+
+	static Float4 Max(Float4 a, Float4 b) { return _mm_max_ps(a.v, b.v); }
+	static Float4 Sqrt(Float4 a) { return _mm_sqrt_ps(a.v); }
+
+	// values in [0, 1] to opaque grey rgba8 in integer lanes
+	static Float4 PackGrey(Float4 value) {
+		__m128 clamped = _mm_min_ps(_mm_max_ps(value.v, _mm_setzero_ps()), _mm_set1_ps(1.0f));
+		__m128i level  = _mm_cvttps_epi32(_mm_add_ps(_mm_mul_ps(clamped, _mm_set1_ps(255.0f)), _mm_set1_ps(0.5f)));
+
+		__m128i rgb = _mm_or_si128(level, _mm_or_si128(_mm_slli_epi32(level, 8), _mm_slli_epi32(level, 16)));
+		return _mm_castsi128_ps(_mm_or_si128(rgb, _mm_set1_epi32((int)0xFF000000u)));
+	}
+
+	friend Float4 operator<(Float4 a, Float4 b) { return _mm_cmplt_ps(a.v, b.v); }
+	friend Float4 operator>(Float4 a, Float4 b) { return _mm_cmpgt_ps(a.v, b.v); }
+	friend Float4 operator<=(Float4 a, Float4 b) { return _mm_cmple_ps(a.v, b.v); }
+	friend Float4 operator==(Float4 a, Float4 b) { return _mm_cmpeq_ps(a.v, b.v); }
+
+	friend Float4 operator&(Float4 a, Float4 b) { return _mm_and_ps(a.v, b.v); }
+	friend Float4 operator|(Float4 a, Float4 b) { return _mm_or_ps(a.v, b.v); }
+
+	// lanes set in mask take a, the others b
+	static Float4 Select(Float4 mask, Float4 a, Float4 b) { return _mm_or_ps(_mm_and_ps(mask.v, a.v), _mm_andnot_ps(mask.v, b.v)); }
+
+	// one bit per lane, lane 0 in the lowest bit
+	int Mask() const { return _mm_movemask_ps(v); }
+#else
+	GLfloat v[4];
+
+	Float4() : v{ 0.0f, 0.0f, 0.0f, 0.0f } {}
+	Float4(GLfloat s) : v{ s, s, s, s } {}
+	Float4(GLfloat a, GLfloat b, GLfloat c, GLfloat d) : v{ a, b, c, d } {}
+
+	static Float4 Load(const GLfloat* p) { return Float4(p[0], p[1], p[2], p[3]); }
+	void Store(GLfloat* p) const { std::memcpy(p, v, sizeof(v)); }
+
+	static uint32_t Bits(GLfloat f) { uint32_t u; std::memcpy(&u, &f, 4); return u; }
+	static GLfloat Float(uint32_t u) { GLfloat f; std::memcpy(&f, &u, 4); return f; }
+	static GLfloat Lane(bool set) { return Float(set ? 0xFFFFFFFFu : 0u); }
+
+	static Float4 Bits(GLuint s) { return Float4(Float(s)); }
+	static Float4 LoadBits(const GLuint* p) { Float4 result; std::memcpy(result.v, p, sizeof(result.v)); return result; }
+	static Float4 EqualBits(Float4 a, Float4 b) { return Apply(a, b, [](GLfloat x, GLfloat y) { return Lane(Bits(x) == Bits(y)); }); }
+	void StoreBits(GLuint* p) const { std::memcpy(p, v, sizeof(v)); }
+
+	template <typename Op>
+	static Float4 Apply(Float4 a, Float4 b, Op op) { return Float4(op(a.v[0], b.v[0]), op(a.v[1], b.v[1]), op(a.v[2], b.v[2]), op(a.v[3], b.v[3])); }
+
+	friend Float4 operator+(Float4 a, Float4 b) { return Apply(a, b, [](GLfloat x, GLfloat y) { return x + y; }); }
+	friend Float4 operator-(Float4 a, Float4 b) { return Apply(a, b, [](GLfloat x, GLfloat y) { return x - y; }); }
+	friend Float4 operator*(Float4 a, Float4 b) { return Apply(a, b, [](GLfloat x, GLfloat y) { return x * y; }); }
+	friend Float4 operator/(Float4 a, Float4 b) { return Apply(a, b, [](GLfloat x, GLfloat y) { return x / y; }); }
+
+	static Float4 Max(Float4 a, Float4 b) { return Apply(a, b, [](GLfloat x, GLfloat y) { return std::max(x, y); }); }
+	static Float4 Sqrt(Float4 a) { return Apply(a, a, [](GLfloat x, GLfloat) { return std::sqrt(x); }); }
+
+	static Float4 PackGrey(Float4 value) {
+		return Apply(value, value, [](GLfloat x, GLfloat) {
+			uint32_t level = (uint32_t)(std::min(std::max(x, 0.0f), 1.0f) * 255.0f + 0.5f);
+			return Float(level | (level << 8) | (level << 16) | 0xFF000000u);
+		});
+	}
+
+	friend Float4 operator<(Float4 a, Float4 b) { return Apply(a, b, [](GLfloat x, GLfloat y) { return Lane(x < y); }); }
+	friend Float4 operator>(Float4 a, Float4 b) { return Apply(a, b, [](GLfloat x, GLfloat y) { return Lane(x > y); }); }
+	friend Float4 operator<=(Float4 a, Float4 b) { return Apply(a, b, [](GLfloat x, GLfloat y) { return Lane(x <= y); }); }
+	friend Float4 operator==(Float4 a, Float4 b) { return Apply(a, b, [](GLfloat x, GLfloat y) { return Lane(x == y); }); }
+
+	friend Float4 operator&(Float4 a, Float4 b) { return Apply(a, b, [](GLfloat x, GLfloat y) { return Float(Bits(x) & Bits(y)); }); }
+	friend Float4 operator|(Float4 a, Float4 b) { return Apply(a, b, [](GLfloat x, GLfloat y) { return Float(Bits(x) | Bits(y)); }); }
+
+	static Float4 Select(Float4 mask, Float4 a, Float4 b) {
+		Float4 result;
+		for (int i = 0; i < 4; i++) result.v[i] = Bits(mask.v[i]) ? a.v[i] : b.v[i];
+
+		return result;
+	}
+
+	int Mask() const {
+		int mask = 0;
+		for (int i = 0; i < 4; i++) mask |= (Bits(v[i]) >> 31) << i;
+
+		return mask;
+	}
+#endif
+};
+
+struct SoftRasterStats {
+	GLuint64 trianglesSubmitted;
+	GLuint64 trianglesRasterized;	// after clipping, trivial rejection and degenerate removal
+	GLuint64 fragments;				// covered pixels that reached the depth test
+	GLuint64 pixelsShaded;			// visible pixels, shaded once each
+
+	GLdouble vertexMs;
+	GLdouble binMs;
+	GLdouble rasterMs;
+	GLdouble totalMs;
+};
+
+// renders MeshObjects on the cpu into an in memory rgba8 framebuffer, for machines without a usable gpu
+// vertices are transformed in parallel, triangles are binned into screen tiles and every tile is rasterized
+// and depth tested by one thread into a visibility buffer, which is then shaded with the model from defaultFrag.glsl
+class SoftRasterizer {
+private:
+	static constexpr GLint TILE_SIZE = 64;		// multiple of 4, rows are stepped four pixels at a time
+
+	// visibility buffer entries are the binning thread in the top bits and the position in its bin below
+	static constexpr GLuint INDEX_BITS	= 26;
+	static constexpr GLuint MAX_THREADS = 63;			// keeps ~0 free to mark empty pixels
+	static constexpr GLuint EMPTY		= 0xFFFFFFFFu;
+
+	// snapping to 1/16 pixel keeps the edge function products exact enough for shared edges to agree
+	static constexpr GLfloat SUBPIXEL = 16.0f;
+
+	struct DrawCall {
+		const GLfloat* vertices;
+		const GLuint*  indices;
+		GLuint attribCount;
+		GLuint vertexBase;		// first transformed vertex
+		GLuint triangleBase;	// first triangle across all queued draws
+
+		glm::mat4 modelView;
+		glm::mat4 modelViewProjection;
+		glm::mat3 normalMat;
+
+		glm::vec3 lightsView[2];
+	};
+
+	struct SoftVertex {
+		glm::vec4 clip;
+		glm::vec3 viewPos;
+		glm::vec3 normal;
+	};
+
+	// E(p) = dx * (p.y - ay) - dy * (p.x - ax), positive inside
+	// shared edges are evaluated from the same endpoint in both triangles so the values are exact negations
+	struct Edge {
+		GLfloat ax, ay;
+		GLfloat dx, dy;
+		GLboolean topLeft;	// pixels exactly on the edge belong to this triangle
+	};
+
+	// a set up triangle, copied into every bin it touches so a tile streams through its own memory
+	// while rasterizing and finds the shading attributes still in cache when it shades
+	struct Triangle {
+		Edge	edges[3];		// edge i is opposite vertex i, so E_i / area is the barycentric of vertex i
+		GLfloat invArea;
+
+		GLfloat z0, dz1, dz2;	// depth = z0 + dz1 * E_1 + dz2 * E_2
+
+		GLint  minX, minY, maxX, maxY;
+		GLuint id;				// visibility buffer value, binning thread and position in its bin
+
+		GLfloat	  invW[3];
+		glm::vec3 viewPos[3];
+		glm::vec3 normal[3];
+
+		GLuint draw;
+	};
+
+	// per thread, padded so counters written by different threads do not share a cache line
+	struct alignas(64) ThreadState {
+		std::vector <std::vector <Triangle>> bins;	// per tile, in submission order
+
+		// tile sized visibility buffer
+		std::vector <GLfloat> depth;
+		std::vector <GLfloat> b1, b2;
+		std::vector <GLuint>  visible;
+
+		GLuint64 trianglesRasterized;
+		GLuint64 fragments;
+		GLuint64 pixelsShaded;
+	};
+
+	std::vector <DrawCall>	 draws;
+	std::vector <SoftVertex> transformed;
+	std::vector <ThreadState> threads;
+
+	GLuint vertexTotal;
+	GLuint triangleTotal;
+
+	GLint tilesX, tilesY;
+
+	glm::vec3 clearColor;
+	std::vector <glm::vec3> lights;
+
+	// persistent workers, Run hands every thread the same job and returns once all of them finished it
+	std::vector <std::thread> workers;
+	std::mutex				  runMutex;
+	std::condition_variable	  runStart;
+	std::condition_variable	  runDone;
+	std::function <void(GLuint)> job;
+	GLuint64 generation;
+	GLuint	 running;
+	GLboolean stopping;
+
+	std::atomic <GLuint> nextTile;
+
+	void WorkerLoop(GLuint index) {
+		GLuint64 seen = 0;
+
+		while (true) {
+			{
+				std::unique_lock <std::mutex> lock(runMutex);
+				runStart.wait(lock, [&] { return stopping || generation != seen; });
+
+				if (stopping) { return; }
+				seen = generation;
+			}
+
+			job(index);
+
+			{
+				std::lock_guard <std::mutex> lock(runMutex);
+				running--;
+			}
+
+			runDone.notify_one();
+		}
+	}
+
+	void Run(std::function <void(GLuint)> work) {
+		{
+			std::lock_guard <std::mutex> lock(runMutex);
+
+			job		= std::move(work);
+			running = (GLuint)workers.size();
+			generation++;
+		}
+
+		runStart.notify_all();
+		job(0);
+
+		std::unique_lock <std::mutex> lock(runMutex);
+		runDone.wait(lock, [this] { return running == 0; });
+	}
+
+	// [begin, end) of count items for thread index
+	void Range(GLuint count, GLuint index, GLuint& begin, GLuint& end) const {
+		begin = (GLuint)((GLuint64)count * index / threads.size());
+		end	  = (GLuint)((GLuint64)count * (index + 1) / threads.size());
+	}
+
+	static SoftVertex Lerp(const SoftVertex& a, const SoftVertex& b, GLfloat t) {
+		return { glm::mix(a.clip, b.clip, t), glm::mix(a.viewPos, b.viewPos, t), glm::mix(a.normal, b.normal, t) };
+	}
+
+	// clips against the near plane, z >= -w, and returns the vertex count of the polygon that is left
+	static GLuint ClipNear(const SoftVertex* in, SoftVertex* out) {
+		GLuint count = 0;
+
+		for (GLuint i = 0; i < 3; i++) {
+			const SoftVertex& a = in[i];
+			const SoftVertex& b = in[(i + 1) % 3];
+
+			GLfloat da = a.clip.z + a.clip.w;
+			GLfloat db = b.clip.z + b.clip.w;
+
+			if (da >= 0.0f) out[count++] = a;
+			if ((da >= 0.0f) != (db >= 0.0f)) out[count++] = Lerp(a, b, da / (da - db));
+		}
+
+		return count;
+	}
+
+	static Edge MakeEdge(GLfloat ax, GLfloat ay, GLfloat bx, GLfloat by) {
+		// evaluate from the lower endpoint, the neighbour sharing this edge then computes exactly -E
+		GLboolean flip = (by < ay) || (by == ay && bx < ax);
+		if (flip) { std::swap(ax, bx); std::swap(ay, by); }
+
+		Edge edge = { ax, ay, bx - ax, by - ay, GL_FALSE };
+		if (flip) { edge.dx = -edge.dx; edge.dy = -edge.dy; }
+
+		// exactly one of two triangles sharing an edge sees it as top left
+		edge.topLeft = edge.dy < 0.0f || (edge.dy == 0.0f && edge.dx > 0.0f);
+		return edge;
+	}
+
+	static GLfloat EdgeAt(const Edge& edge, GLfloat x, GLfloat y) {
+		return edge.dx * (y - edge.ay) - edge.dy * (x - edge.ax);
+	}
+
+	// projects a clipped triangle to the screen, fails for degenerate and off screen triangles
+	GLboolean Setup(const SoftVertex* v, GLuint draw, GLboolean hasNormals, Triangle& tri) const {
+		GLfloat x[3], y[3];
+
+		for (GLuint i = 0; i < 3; i++) {
+			tri.invW[i] = 1.0f / v[i].clip.w;
+
+			x[i] = std::round(((v[i].clip.x * tri.invW[i]) * 0.5f + 0.5f) * width * SUBPIXEL) / SUBPIXEL;
+			y[i] = std::round((0.5f - (v[i].clip.y * tri.invW[i]) * 0.5f) * height * SUBPIXEL) / SUBPIXEL;
+		}
+
+		// pixel centers inside the bounding box
+		tri.minX = std::max(0, (GLint)std::ceil(std::min({ x[0], x[1], x[2] }) - 0.5f));
+		tri.minY = std::max(0, (GLint)std::ceil(std::min({ y[0], y[1], y[2] }) - 0.5f));
+		tri.maxX = std::min(width - 1, (GLint)std::floor(std::max({ x[0], x[1], x[2] }) - 0.5f));
+		tri.maxY = std::min(height - 1, (GLint)std::floor(std::max({ y[0], y[1], y[2] }) - 0.5f));
+
+		if (tri.minX > tri.maxX || tri.minY > tri.maxY) { return GL_FALSE; }
+
+		// no culling, the gl path draws both faces too
+		GLuint order[3] = { 0, 1, 2 };
+
+		GLfloat area = (x[1] - x[0]) * (y[2] - y[0]) - (y[1] - y[0]) * (x[2] - x[0]);
+		if (area == 0.0f) { return GL_FALSE; }
+		if (area < 0.0f) std::swap(order[1], order[2]);
+
+		for (GLuint i = 0; i < 3; i++) {
+			GLuint a = order[(i + 1) % 3], b = order[(i + 2) % 3];
+			tri.edges[i] = MakeEdge(x[a], y[a], x[b], y[b]);
+		}
+
+		area = EdgeAt(tri.edges[2], x[order[2]], y[order[2]]);
+		if (area <= 0.0f) { return GL_FALSE; }
+
+		tri.invArea = 1.0f / area;
+
+		GLfloat z[3];
+		for (GLuint i = 0; i < 3; i++) z[i] = (v[order[i]].clip.z * tri.invW[order[i]]) * 0.5f + 0.5f;
+
+		tri.z0  = z[0];
+		tri.dz1 = (z[1] - z[0]) * tri.invArea;
+		tri.dz2 = (z[2] - z[0]) * tri.invArea;
+
+		GLfloat invW[3] = { tri.invW[order[0]], tri.invW[order[1]], tri.invW[order[2]] };
+
+		for (GLuint i = 0; i < 3; i++) {
+			tri.invW[i]	   = invW[i];
+			tri.viewPos[i] = v[order[i]].viewPos;
+			tri.normal[i]  = v[order[i]].normal;
+		}
+
+		if (!hasNormals) {
+			glm::vec3 face = glm::normalize(glm::cross(tri.viewPos[1] - tri.viewPos[0], tri.viewPos[2] - tri.viewPos[0]));
+			if (glm::dot(face, tri.viewPos[0]) > 0.0f) face = -face;
+
+			tri.normal[0] = tri.normal[1] = tri.normal[2] = face;
+		}
+
+		tri.draw = draw;
+		return GL_TRUE;
+	}
+
+	void Bin(GLuint thread, Triangle& tri) {
+		ThreadState& state = threads[thread];
+
+		for (GLint ty = tri.minY / TILE_SIZE; ty <= tri.maxY / TILE_SIZE; ty++) {
+			for (GLint tx = tri.minX / TILE_SIZE; tx <= tri.maxX / TILE_SIZE; tx++) {
+				std::vector <Triangle>& bin = state.bins[ty * tilesX + tx];
+				if (bin.size() >> INDEX_BITS) { continue; }
+
+				tri.id = (thread << INDEX_BITS) | (GLuint)bin.size();
+				bin.push_back(tri);
+			}
+		}
+
+		state.trianglesRasterized++;
+	}
+
+	void TransformVertices(GLuint index) {
+		GLuint begin, end;
+		Range(vertexTotal, index, begin, end);
+
+		GLuint drawIndex = 0;
+
+		for (GLuint i = begin; i < end; i++) {
+			while (drawIndex + 1 < draws.size() && i >= draws[drawIndex + 1].vertexBase) drawIndex++;
+
+			const DrawCall& draw = draws[drawIndex];
+			const GLfloat* in = draw.vertices + (size_t)(i - draw.vertexBase) * draw.attribCount;
+
+			glm::vec4 position(in[0], in[1], in[2], 1.0f);
+
+			SoftVertex& out = transformed[i];
+			out.clip	= draw.modelViewProjection * position;
+			out.viewPos = glm::vec3(draw.modelView * position);
+			out.normal	= (draw.attribCount == 6) ? glm::normalize(draw.normalMat * glm::vec3(in[3], in[4], in[5])) : glm::vec3(0.0f);
+		}
+	}
+
+	void SetupTriangles(GLuint index) {
+		ThreadState& state = threads[index];
+
+		state.trianglesRasterized = 0;
+		for (std::vector <Triangle>& bin : state.bins) bin.clear();
+
+		GLuint begin, end;
+		Range(triangleTotal, index, begin, end);
+
+		GLuint drawIndex = 0;
+
+		for (GLuint t = begin; t < end; t++) {
+			while (drawIndex + 1 < draws.size() && t >= draws[drawIndex + 1].triangleBase) drawIndex++;
+
+			const DrawCall& draw = draws[drawIndex];
+			const GLuint* corner = draw.indices + 3 * (size_t)(t - draw.triangleBase);
+
+			SoftVertex v[3] = {
+				transformed[draw.vertexBase + corner[0]],
+				transformed[draw.vertexBase + corner[1]],
+				transformed[draw.vertexBase + corner[2]]
+			};
+
+			// trivially rejected when every vertex is outside the same side or far plane
+			GLboolean outside = GL_FALSE;
+			for (GLuint axis = 0; axis < 3 && !outside; axis++) {
+				outside = (v[0].clip[axis] > v[0].clip.w && v[1].clip[axis] > v[1].clip.w && v[2].clip[axis] > v[2].clip.w)
+					|| (axis < 2 && v[0].clip[axis] < -v[0].clip.w && v[1].clip[axis] < -v[1].clip.w && v[2].clip[axis] < -v[2].clip.w);
+			}
+			if (outside) { continue; }
+
+			SoftVertex clipped[4];
+			GLuint count = ClipNear(v, clipped);
+
+			Triangle tri;
+
+			for (GLuint i = 2; i < count; i++) {
+				SoftVertex fan[3] = { clipped[0], clipped[i - 1], clipped[i] };
+
+				if (Setup(fan, drawIndex, draw.attribCount == 6, tri)) Bin(index, tri);
+			}
+		}
+	}
+
+	void RasterTriangle(ThreadState& state, const Triangle& tri, GLint tileX, GLint tileY, GLint tileW, GLint tileH) {
+		GLint x0 = std::max(tri.minX, tileX), x1 = std::min(tri.maxX, tileX + tileW - 1);
+		GLint y0 = std::max(tri.minY, tileY), y1 = std::min(tri.maxY, tileY + tileH - 1);
+
+		if (x0 > x1 || y0 > y1) { return; }
+
+		// four pixel groups are aligned to the tile, lanes past the triangle fail the edge tests
+		x0 = tileX + ((x0 - tileX) & ~3);
+
+		const Float4 laneOffset(0.5f, 1.5f, 2.5f, 3.5f);
+		const Float4 zero(0.0f), one(1.0f);
+
+		Float4 edgeDy[3], edgeAx[3], topLeft[3];
+		for (GLuint i = 0; i < 3; i++) {
+			edgeDy[i]  = Float4(tri.edges[i].dy);
+			edgeAx[i]  = Float4(tri.edges[i].ax);
+			topLeft[i] = tri.edges[i].topLeft ? (zero == zero) : (zero < zero);
+		}
+
+		const Float4 z0(tri.z0), dz1(tri.dz1), dz2(tri.dz2), invArea(tri.invArea);
+		const Float4 idLanes = Float4::Bits(tri.id);
+
+		static const GLuint laneCount[16] = { 0, 1, 1, 2, 1, 2, 2, 3, 1, 2, 2, 3, 2, 3, 3, 4 };
+
+		for (GLint y = y0; y <= y1; y++) {
+			GLfloat py = y + 0.5f;
+
+			Float4 row[3];
+			for (GLuint i = 0; i < 3; i++) row[i] = Float4(tri.edges[i].dx * (py - tri.edges[i].ay));
+
+			GLuint rowOffset = (y - tileY) * TILE_SIZE;
+
+			for (GLint x = x0; x <= x1; x += 4) {
+				Float4 px = Float4((GLfloat)x) + laneOffset;
+
+				Float4 e0 = row[0] - edgeDy[0] * (px - edgeAx[0]);
+				Float4 e1 = row[1] - edgeDy[1] * (px - edgeAx[1]);
+				Float4 e2 = row[2] - edgeDy[2] * (px - edgeAx[2]);
+
+				Float4 inside = ((e0 > zero) | ((e0 == zero) & topLeft[0]))
+					& ((e1 > zero) | ((e1 == zero) & topLeft[1]))
+					& ((e2 > zero) | ((e2 == zero) & topLeft[2]));
+
+				int covered = inside.Mask();
+				if (covered == 0) { continue; }
+
+				GLuint offset = rowOffset + (x - tileX);
+
+				Float4 z	 = z0 + dz1 * e1 + dz2 * e2;
+				Float4 depth = Float4::Load(&state.depth[offset]);
+				Float4 pass	 = inside & (z < depth) & (z <= one);
+
+				state.fragments += laneCount[covered];
+
+				// selects instead of per lane branches, which mispredict on small triangles
+				Float4::Select(pass, z, depth).Store(&state.depth[offset]);
+				Float4::Select(pass, e1 * invArea, Float4::Load(&state.b1[offset])).Store(&state.b1[offset]);
+				Float4::Select(pass, e2 * invArea, Float4::Load(&state.b2[offset])).Store(&state.b2[offset]);
+				Float4::Select(pass, idLanes, Float4::LoadBits(&state.visible[offset])).StoreBits(&state.visible[offset]);
+			}
+		}
+	}
+
+	// three components for four pixels
+	struct Vec3x4 {
+		Float4 x, y, z;
+	};
+
+	static Float4 Dot(const Vec3x4& a, const Vec3x4& b) {
+		return a.x * b.x + a.y * b.y + a.z * b.z;
+	}
+
+	static Vec3x4 Normalize(const Vec3x4& a) {
+		Float4 scale = Float4(1.0f) / Float4::Sqrt(Dot(a, a));
+		return { a.x * scale, a.y * scale, a.z * scale };
+	}
+
+	static uint32_t Pack(GLfloat r, GLfloat g, GLfloat b) {
+		r = std::min(std::max(r, 0.0f), 1.0f) * 255.0f + 0.5f;
+		g = std::min(std::max(g, 0.0f), 1.0f) * 255.0f + 0.5f;
+		b = std::min(std::max(b, 0.0f), 1.0f) * 255.0f + 0.5f;
+
+		return (uint32_t)r | ((uint32_t)g << 8) | ((uint32_t)b << 16) | 0xFF000000u;
+	}
+
+	// the lighting of defaultFrag.glsl in view space for four neighbouring pixels, returns how many were visible
+	// attributes are interpolated once per distinct triangle in the group, usually one or two
+	GLuint ShadeGroup(const ThreadState& state, GLuint tile, GLuint offset, uint32_t background, uint32_t* out) const {
+		Float4 ids = Float4::LoadBits(&state.visible[offset]);
+		Float4 b1  = Float4::Load(&state.b1[offset]);
+		Float4 b2  = Float4::Load(&state.b2[offset]);
+
+		int visibleLanes = 0xF & ~Float4::EqualBits(ids, Float4::Bits(EMPTY)).Mask();
+
+		if (visibleLanes == 0) {
+			for (GLuint lane = 0; lane < 4; lane++) out[lane] = background;
+			return 0;
+		}
+
+		// harmless values for empty lanes, they are replaced by the background below
+		Vec3x4 fragPos	  = { Float4(0.0f), Float4(0.0f), Float4(-1.0f) };
+		Vec3x4 vertNormal = { Float4(0.0f), Float4(0.0f), Float4(1.0f) };
+		Vec3x4 lightPos[2];
+
+		for (int remaining = visibleLanes; remaining != 0; ) {
+			GLuint lane = 0;
+			while (!(remaining & (1 << lane))) lane++;
+
+			GLuint id = state.visible[offset + lane];
+			Float4 match = Float4::EqualBits(ids, Float4::Bits(id));
+			remaining &= ~match.Mask();
+
+			const Triangle& tri = threads[id >> INDEX_BITS].bins[tile][id & ((1u << INDEX_BITS) - 1)];
+			const DrawCall& draw = draws[tri.draw];
+
+			// perspective correct weights
+			Float4 w0 = (Float4(1.0f) - b1 - b2) * Float4(tri.invW[0]);
+			Float4 w1 = b1 * Float4(tri.invW[1]);
+			Float4 w2 = b2 * Float4(tri.invW[2]);
+			Float4 scale = Float4(1.0f) / (w0 + w1 + w2);
+
+			w0 = w0 * scale; w1 = w1 * scale; w2 = w2 * scale;
+
+			Float4* position[3] = { &fragPos.x, &fragPos.y, &fragPos.z };
+			Float4* normal[3]	= { &vertNormal.x, &vertNormal.y, &vertNormal.z };
+
+			for (GLuint c = 0; c < 3; c++) {
+				Float4 p = w0 * Float4(tri.viewPos[0][c]) + w1 * Float4(tri.viewPos[1][c]) + w2 * Float4(tri.viewPos[2][c]);
+				Float4 n = w0 * Float4(tri.normal[0][c]) + w1 * Float4(tri.normal[1][c]) + w2 * Float4(tri.normal[2][c]);
+
+				*position[c] = Float4::Select(match, p, *position[c]);
+				*normal[c]	 = Float4::Select(match, n, *normal[c]);
+			}
+
+			for (GLuint i = 0; i < 2; i++) {
+				lightPos[i].x = Float4::Select(match, Float4(draw.lightsView[i].x), lightPos[i].x);
+				lightPos[i].y = Float4::Select(match, Float4(draw.lightsView[i].y), lightPos[i].y);
+				lightPos[i].z = Float4::Select(match, Float4(draw.lightsView[i].z), lightPos[i].z);
+			}
+		}
+
+		const Float4 zero(0.0f);
+
+		Vec3x4 viewDir = Normalize(fragPos);
+
+		Float4 diff(0.0f);
+		Float4 spec(0.0f);
+
+		for (GLuint i = 0; i < 2; i++) {
+			Vec3x4 lightDir = Normalize({ lightPos[i].x - fragPos.x, lightPos[i].y - fragPos.y, lightPos[i].z - fragPos.z });
+
+			// reflect(lightDir, vertNormal)
+			Float4 twoDot = Float4(2.0f) * Dot(vertNormal, lightDir);
+			Vec3x4 reflectDir = { lightDir.x - twoDot * vertNormal.x, lightDir.y - twoDot * vertNormal.y, lightDir.z - twoDot * vertNormal.z };
+
+			diff = diff + Float4::Max(Dot(lightDir, vertNormal), zero);
+
+			// pow(x, 64) by squaring, bases below 0.3 end up under 1e-33 and are dropped
+			// before the squaring reaches denormals, which are many times slower on x86
+			Float4 s = Dot(reflectDir, viewDir);
+			s = Float4::Select(s > Float4(0.3f), s, zero);
+			s = s * s; s = s * s; s = s * s; s = s * s; s = s * s; s = s * s;
+			spec = spec + s;
+		}
+
+		// vec3(0.1) + diff * vec3(0.8) + spec * vec3(1.0), the same for every channel
+		Float4 shade = Float4::PackGrey(Float4(0.1f) + diff * Float4(0.8f) + spec);
+		Float4 empty = Float4::EqualBits(ids, Float4::Bits(EMPTY));
+
+		Float4::Select(empty, Float4::Bits(background), shade).StoreBits(out);
+
+		static const GLuint laneCount[16] = { 0, 1, 1, 2, 1, 2, 2, 3, 1, 2, 2, 3, 2, 3, 3, 4 };
+		return laneCount[visibleLanes];
+	}
+
+	void RasterTile(ThreadState& state, GLuint tile) {
+		GLint tileX = (tile % tilesX) * TILE_SIZE;
+		GLint tileY = (tile / tilesX) * TILE_SIZE;
+		GLint tileW = std::min(TILE_SIZE, width - tileX);
+		GLint tileH = std::min(TILE_SIZE, height - tileY);
+
+		std::fill(state.depth.begin(), state.depth.end(), 1.0f);
+		std::fill(state.visible.begin(), state.visible.end(), EMPTY);
+
+		// walking the threads in order keeps submission order, which decides equal depth ties
+		for (ThreadState& source : threads) {
+			for (const Triangle& tri : source.bins[tile]) RasterTriangle(state, tri, tileX, tileY, tileW, tileH);
+		}
+
+		uint32_t background = Pack(clearColor.r, clearColor.g, clearColor.b);
+
+		// every visible pixel is shaded exactly once, after all triangles of the tile are depth tested
+		for (GLint y = 0; y < tileH; y++) {
+			uint32_t* colorRow = &color[(size_t)(tileY + y) * width + tileX];
+			GLfloat*  depthRow = &depth[(size_t)(tileY + y) * width + tileX];
+
+			for (GLint x = 0; x < tileW; x += 4) {
+				GLuint offset = y * TILE_SIZE + x;
+				GLuint count  = std::min(4, tileW - x);
+
+				uint32_t shaded[4];
+				state.pixelsShaded += ShadeGroup(state, tile, offset, background, shaded);
+
+				std::memcpy(colorRow + x, shaded, count * sizeof(uint32_t));
+				std::memcpy(depthRow + x, &state.depth[offset], count * sizeof(GLfloat));
+			}
+		}
+	}
+
+	void RasterTiles(GLuint index) {
+		ThreadState& state = threads[index];
+
+		for (GLuint tile = nextTile++; tile < (GLuint)(tilesX * tilesY); tile = nextTile++) {
+			RasterTile(state, tile);
+		}
+	}
+
+	void AllocateTiles() {
+		tilesX = (width + TILE_SIZE - 1) / TILE_SIZE;
+		tilesY = (height + TILE_SIZE - 1) / TILE_SIZE;
+
+		color.assign((size_t)width * height, 0);
+		depth.assign((size_t)width * height, 1.0f);
+
+		for (ThreadState& state : threads) state.bins.resize(tilesX * tilesY);
+	}
+
+public:
+	GLint width;
+	GLint height;
+
+	// rgba8 packed with red in the lowest byte, rows from the top of the image down
+	std::vector <uint32_t> color;
+	std::vector <GLfloat>  depth;
+
+	SoftRasterStats stats;
+
+	// threadCount 0 uses every core
+	SoftRasterizer(GLint width, GLint height, GLuint threadCount = 0) {
+		this->width	 = (width > 0) ? width : 1;
+		this->height = (height > 0) ? height : 1;
+
+		if (threadCount == 0) threadCount = std::max(1u, std::thread::hardware_concurrency());
+		threadCount = std::min(threadCount, MAX_THREADS);
+
+		threads = std::vector <ThreadState>(threadCount);
+
+		for (ThreadState& state : threads) {
+			state.depth.resize(TILE_SIZE * TILE_SIZE);
+			state.b1.resize(TILE_SIZE * TILE_SIZE);
+			state.b2.resize(TILE_SIZE * TILE_SIZE);
+			state.visible.resize(TILE_SIZE * TILE_SIZE);
+		}
+
+		AllocateTiles();
+
+		vertexTotal	  = 0;
+		triangleTotal = 0;
+
+		clearColor = glm::vec3(0.0f);
+		std::memset(&stats, 0, sizeof(stats));
+
+		generation = 0;
+		running	   = 0;
+		stopping   = GL_FALSE;
+
+		for (GLuint i = 1; i < threadCount; i++) {
+			workers.emplace_back(&SoftRasterizer::WorkerLoop, this, i);
+		}
+	}
+
+	SoftRasterizer(const SoftRasterizer&) = delete;
+	SoftRasterizer& operator=(const SoftRasterizer&) = delete;
+
+	GLuint ThreadCount() const {
+		return (GLuint)threads.size();
+	}
+
+	void Resize(GLint width, GLint height) {
+		if (width <= 0 || height <= 0 || (width == this->width && height == this->height)) { return; }
+
+		this->width	 = width;
+		this->height = height;
+
+		AllocateTiles();
+	}
+
+	void SetClearColor(glm::vec3 color) {
+		clearColor = color;
+	}
+
+	// world space, like the lightPosition uniform
+	void SetLights(const std::vector <glm::vec3>& positions) {
+		lights = positions;
+	}
+
+	// queues a mesh, its cpu side vertices and indices have to stay alive until Render returns
+	void Draw(const MeshObject& mesh, Camera camera) {
+		if (mesh.vertices.empty() || mesh.indices.empty()) {
+			std::cout << "ERROR::SOFT_RASTERIZER::MESH_HAS_NO_CPU_DATA" << std::endl;
+			return;
+		}
+
+		DrawCall draw;
+		draw.vertices	 = mesh.vertices.data();
+		draw.indices	 = mesh.indices.data();
+		draw.attribCount = mesh.attribCount;
+		draw.vertexBase	 = vertexTotal;
+		draw.triangleBase = triangleTotal;
+
+		glm::mat4 view = camera.GetViewMat();
+
+		draw.modelView			 = view * mesh.model_mat;
+		draw.modelViewProjection = camera.projection_mat * draw.modelView;
+		draw.normalMat			 = glm::mat3(glm::transpose(glm::inverse(draw.modelView)));
+
+		// the shader reads two lights, unset uniforms are zero
+		for (GLuint i = 0; i < 2; i++) {
+			glm::vec3 light = (i < lights.size()) ? lights[i] : glm::vec3(0.0f);
+			draw.lightsView[i] = glm::vec3(view * glm::vec4(light, 1.0f));
+		}
+
+		draws.push_back(std::move(draw));
+
+		vertexTotal	  += mesh.vertCount;
+		triangleTotal += mesh.triCount;
+	}
+
+	// renders every queued draw into color and depth, then empties the queue
+	void Render() {
+		std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+
+		transformed.resize(vertexTotal);
+
+		for (ThreadState& state : threads) {
+			state.fragments	   = 0;
+			state.pixelsShaded = 0;
+		}
+
+		Run([this](GLuint index) { TransformVertices(index); });
+		std::chrono::steady_clock::time_point transformedAt = std::chrono::steady_clock::now();
+
+		Run([this](GLuint index) { SetupTriangles(index); });
+		std::chrono::steady_clock::time_point binnedAt = std::chrono::steady_clock::now();
+
+		nextTile = 0;
+		Run([this](GLuint index) { RasterTiles(index); });
+		std::chrono::steady_clock::time_point end = std::chrono::steady_clock::now();
+
+		stats.trianglesSubmitted  = triangleTotal;
+		stats.trianglesRasterized = 0;
+		stats.fragments			  = 0;
+		stats.pixelsShaded		  = 0;
+
+		for (ThreadState& state : threads) {
+			stats.trianglesRasterized += state.trianglesRasterized;
+			stats.fragments			  += state.fragments;
+			stats.pixelsShaded		  += state.pixelsShaded;
+		}
+
+		stats.vertexMs = std::chrono::duration<GLdouble, std::milli>(transformedAt - start).count();
+		stats.binMs	   = std::chrono::duration<GLdouble, std::milli>(binnedAt - transformedAt).count();
+		stats.rasterMs = std::chrono::duration<GLdouble, std::milli>(end - binnedAt).count();
+		stats.totalMs  = std::chrono::duration<GLdouble, std::milli>(end - start).count();
+
+		draws.clear();
+		vertexTotal	  = 0;
+		triangleTotal = 0;
+	}
+
+	// rgb8 rows from the top down, the layout ImageWriter expects
+	std::vector <unsigned char> RGB() const {
+		std::vector <unsigned char> rgb(3 * color.size());
+
+		for (size_t i = 0; i < color.size(); i++) {
+			rgb[3 * i]	   = (unsigned char)color[i];
+			rgb[3 * i + 1] = (unsigned char)(color[i] >> 8);
+			rgb[3 * i + 2] = (unsigned char)(color[i] >> 16);
+		}
+
+		return rgb;
+	}
+
+	~SoftRasterizer() {
+		{
+			std::lock_guard <std::mutex> lock(runMutex);
+			stopping = GL_TRUE;
+		}
+
+		runStart.notify_all();
+		for (std::thread& worker : workers) worker.join();
+	}
+};
\ No newline at end of file
@@ -0,0 +1,137 @@
+#pragma once
+
+#include "3d_shapes.h"
+
+#include <string>
+
+// screen space text drawn with a built in 3x5 pixel font, every lit font pixel becomes a quad
+// all text printed during a frame goes out in a single draw call
+class TextOverlay {
+private:
+	GLuint VAO;
+	GLuint VBO;
+
+	GLsizeiptr bufferSize;
+
+	// glyphs for ' ' to '_', 5 rows of 3 bits each from the top row down, lower case maps to upper case
+	static GLushort Glyph(char c) {
+		static const GLushort glyphs[64] = {
+			0x0000, 0x2482, 0x0000, 0x0000, 0x0000, 0x52A5, 0x0000, 0x0000,	// sp ! " # $ % & '
+			0x1491, 0x4494, 0x0000, 0x05D0, 0x0014, 0x01C0, 0x0002, 0x12A4,	// ( ) * + , - . /
+			0x7B6F, 0x2C97, 0x73E7, 0x72CF, 0x5BC9, 0x79CF, 0x79EF, 0x7252,	// 0 1 2 3 4 5 6 7
+			0x7BEF, 0x7BCF, 0x0410, 0x0000, 0x1511, 0x0E38, 0x4454, 0x0000,	// 8 9 : ; < = > ?
+			0x0000, 0x2BED, 0x6BAE, 0x3923, 0x6B6E, 0x79A7, 0x79A4, 0x396B,	// @ A B C D E F G
+			0x5BED, 0x7497, 0x126A, 0x5BAD, 0x4927, 0x5FED, 0x6B6D, 0x2B6A,	// H I J K L M N O
+			0x6BA4, 0x2B73, 0x6BAD, 0x388E, 0x7492, 0x5B6F, 0x5B6A, 0x5BFD,	// P Q R S T U V W
+			0x5AAD, 0x5A92, 0x72A7, 0x3493, 0x0000, 0x6496, 0x0000, 0x0007	// X Y Z [ \ ] ^ _
+		};
+
+		if (c >= 'a' && c <= 'z') c -= 'a' - 'A';
+		if (c < ' ' || c > '_') return 0;
+
+		return glyphs[c - ' '];
+	}
+
+public:
+	std::vector <GLfloat> vertices;
+
+	GLuint	shaderProgram;
+	GLfloat pixelSize;
+
+	TextOverlay(GLfloat pixelSize = 2.0f) {
+		glGenVertexArrays(1, &VAO);
+		glGenBuffers(1, &VBO);
+
+		glBindVertexArray(VAO);
+
+			glBindBuffer(GL_ARRAY_BUFFER, VBO);
+			glVertexAttribPointer(0, 2, GL_FLOAT, GL_FALSE, 2 * sizeof(GLfloat), (void*)0);
+			glEnableVertexAttribArray(0);
+
+		glBindVertexArray(0);
+
+		this->bufferSize	= 0;
+		this->shaderProgram = 0;
+		this->pixelSize		= pixelSize;
+	}
+
+	void SetShader(GLuint program) {
+		this->shaderProgram = program;
+	}
+
+	// x and y are in pixels from the top left corner of the window
+	void Print(GLfloat x, GLfloat y, const std::string& text) {
+		GLfloat penX = x;
+
+		for (char c : text) {
+			if (c == '\n') {
+				penX = x;
+				y += 6 * pixelSize;
+				continue;
+			}
+
+			GLushort glyph = Glyph(c);
+
+			for (GLuint row = 0; row < 5; row++) {
+				for (GLuint col = 0; col < 3; col++) {
+					if (!(glyph & (1 << (14 - row * 3 - col)))) continue;
+
+					GLfloat x0 = penX + col * pixelSize;
+					GLfloat y0 = y + row * pixelSize;
+					GLfloat x1 = x0 + pixelSize;
+					GLfloat y1 = y0 + pixelSize;
+
+					vertices.insert(vertices.end(), {
+						x0, y0,  x1, y0,  x1, y1,
+						x0, y0,  x1, y1,  x0, y1
+					});
+				}
+			}
+
+			penX += 4 * pixelSize;
+		}
+	}
+
+	// draws everything printed since the last call and clears the text
+	void Draw(GLint width, GLint height, glm::vec4 color = glm::vec4(1.0f, 1.0f, 1.0f, 1.0f)) {
+		if (vertices.empty()) { return; }
+
+		GLsizeiptr size = vertices.size() * sizeof(GLfloat);
+
+		glBindBuffer(GL_ARRAY_BUFFER, VBO);
+
+		// orphan the old storage so the driver does not wait on last frame's draw
+		if (size > bufferSize) bufferSize = size;
+		glBufferData(GL_ARRAY_BUFFER, bufferSize, nullptr, GL_STREAM_DRAW);
+		glBufferSubData(GL_ARRAY_BUFFER, 0, size, vertices.data());
+
+		glBindBuffer(GL_ARRAY_BUFFER, 0);
+
+		glUseProgram(shaderProgram);
+
+			GLint size_loc	= glGetUniformLocation(shaderProgram, "screenSize");
+			GLint color_loc = glGetUniformLocation(shaderProgram, "vertColor");
+
+			if (size_loc != -1) glUniform2f(size_loc, (GLfloat)width, (GLfloat)height);
+			if (color_loc != -1) glUniform4f(color_loc, color[0], color[1], color[2], color[3]);
+
+			GLboolean depthTest = glIsEnabled(GL_DEPTH_TEST);
+			glDisable(GL_DEPTH_TEST);
+			glPolygonMode(GL_FRONT_AND_BACK, GL_FILL);
+
+			glBindVertexArray(VAO);
+			glDrawArrays(GL_TRIANGLES, 0, (GLsizei)(vertices.size() / 2));
+			glBindVertexArray(0);
+
+			if (depthTest) glEnable(GL_DEPTH_TEST);
+
+		glUseProgram(0);
+
+		vertices.clear();
+	}
+
+	~TextOverlay() {
+		glDeleteBuffers(1, &VBO);
+		glDeleteVertexArrays(1, &VAO);
+	}
+};
\ No newline at end of file
@@ -0,0 +1,9 @@
+#version 330 core
+
+in vec4 lineColor;
+
+out vec4 color;
+
+void main() {
+	color = lineColor;
+}
\ No newline at end of file
@@ -0,0 +1,13 @@
+#version 330 core
+
+layout (location = 0) in vec3 position;
+layout (location = 1) in vec4 color;	// rgba8, normalized
+
+uniform mat4 viewProjection;
+
+out vec4 lineColor;
+
+void main() {
+	lineColor	= color;
+	gl_Position = viewProjection * vec4(position, 1.0f);
+}
\ No newline at end of file
@@ -3,6 +3,7 @@
 layout (location = 0) in vec3 position;
 layout (location = 1) in vec3 normal;
 
+uniform mat4 model;
 uniform mat4 view;
 uniform mat4 projection;
 
@@ -14,12 +15,12 @@ out vec3 vertNormal;
 out vec3 lightPosView[3];
 
 void main(){
-	gl_Position  = projection * view * vec4(position, 1.0f);
+	gl_Position  = projection * view * model * vec4(position, 1.0f);
 	
 	for (int i = 0; i < 3; i++) {
 		lightPosView[i] = vec3(view * vec4(lightPosition[i], 1.0f));
 	}
 
-	fragPos = vec3(view * vec4(position, 1.0f));
+	fragPos = vec3(view * model * vec4(position, 1.0f));
 	vertNormal = normalize(normal_mat * normal);
 }
\ No newline at end of file
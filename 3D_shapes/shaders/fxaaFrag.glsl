@@ -0,0 +1,67 @@
+#version 330 core
+
+// upscales the scene with bilinear filtering and smooths its edges like the console variant of fxaa 3.11
+// the neighbourhood is one source texel wide, so edges are found at the resolution they were rendered at
+
+in vec2 texCoord;
+
+uniform sampler2D source;
+uniform vec2 texelSize;		// one source texel in texture coordinates
+uniform vec2 sourceMax;		// center of the last rendered texel, nothing past it is sampled
+uniform int fxaaEnabled;
+
+out vec4 fragColor;
+
+const float EDGE_THRESHOLD	   = 0.125f;
+const float EDGE_THRESHOLD_MIN = 0.0312f;
+const float SPAN_MAX		   = 8.0f;
+const float REDUCE_MUL		   = 1.0f / 8.0f;
+const float REDUCE_MIN		   = 1.0f / 128.0f;
+
+float luma(vec3 color) {
+	return dot(color, vec3(0.299f, 0.587f, 0.114f));
+}
+
+vec3 fetch(vec2 coord) {
+	return texture(source, min(coord, sourceMax)).rgb;
+}
+
+void main() {
+	vec3 center = fetch(texCoord);
+
+	if (fxaaEnabled == 0) {
+		fragColor = vec4(center, 1.0f);
+		return;
+	}
+
+	// half texel offsets, every tap is the average of four texels
+	float lumaNW = luma(fetch(texCoord + vec2(-0.5f,  0.5f) * texelSize));
+	float lumaNE = luma(fetch(texCoord + vec2( 0.5f,  0.5f) * texelSize));
+	float lumaSW = luma(fetch(texCoord + vec2(-0.5f, -0.5f) * texelSize));
+	float lumaSE = luma(fetch(texCoord + vec2( 0.5f, -0.5f) * texelSize));
+	float lumaM	 = luma(center);
+
+	float lumaMin = min(lumaM, min(min(lumaNW, lumaNE), min(lumaSW, lumaSE)));
+	float lumaMax = max(lumaM, max(max(lumaNW, lumaNE), max(lumaSW, lumaSE)));
+
+	// flat areas keep the plain upscale
+	if (lumaMax - lumaMin < max(EDGE_THRESHOLD_MIN, lumaMax * EDGE_THRESHOLD)) {
+		fragColor = vec4(center, 1.0f);
+		return;
+	}
+
+	// along the edge, perpendicular to the luma gradient
+	vec2 direction = vec2(-((lumaNW + lumaNE) - (lumaSW + lumaSE)), (lumaNW + lumaSW) - (lumaNE + lumaSE));
+
+	float reduce = max(0.25f * (lumaNW + lumaNE + lumaSW + lumaSE) * REDUCE_MUL, REDUCE_MIN);
+	float scale	 = 1.0f / (min(abs(direction.x), abs(direction.y)) + reduce);
+
+	direction = clamp(direction * scale, -SPAN_MAX, SPAN_MAX) * texelSize;
+
+	vec3 inner = 0.5f * (fetch(texCoord + direction * (1.0f / 3.0f - 0.5f)) + fetch(texCoord + direction * (2.0f / 3.0f - 0.5f)));
+	vec3 outer = 0.5f * inner + 0.25f * (fetch(texCoord - 0.5f * direction) + fetch(texCoord + 0.5f * direction));
+
+	// the wide blur crossed another edge if it left the local luma range
+	float lumaOuter = luma(outer);
+	fragColor = vec4((lumaOuter < lumaMin || lumaOuter > lumaMax) ? inner : outer, 1.0f);
+}
\ No newline at end of file
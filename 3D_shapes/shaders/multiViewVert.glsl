@@ -0,0 +1,50 @@
+#version 330 core
+
+// defaultVert for up to four views at once, drawn instanced with one instance per view that sees the mesh
+// every view is squeezed into its own rectangle of the target and clipped to it, so no viewport array is needed
+
+layout (location = 0) in vec3 position;
+layout (location = 1) in vec3 normal;
+
+// filled once per frame by MultiView, std140 lays it out exactly like the c++ struct
+layout (std140) uniform Views {
+	mat4 viewMats[4];
+	mat4 projections[4];
+	vec4 viewRects[4];		// x0 y0 x1 y1 in normalized device coordinates of the whole target
+};
+
+uniform mat4 model;
+uniform ivec4 viewIndices;	// view drawn by each instance, views that culled the mesh are left out
+
+uniform vec3 lightPosition[3];
+
+out vec3 fragPos;
+out vec3 vertNormal;
+out vec3 lightPosView[3];
+
+out float gl_ClipDistance[4];
+
+void main(){
+	int viewIndex = viewIndices[gl_InstanceID];
+
+	mat4 view = viewMats[viewIndex];
+	vec4 rect = viewRects[viewIndex];
+	vec4 clip = projections[viewIndex] * view * model * vec4(position, 1.0f);
+
+	// the edges of the view before it is moved into its rectangle
+	gl_ClipDistance[0] = clip.w + clip.x;
+	gl_ClipDistance[1] = clip.w - clip.x;
+	gl_ClipDistance[2] = clip.w + clip.y;
+	gl_ClipDistance[3] = clip.w - clip.y;
+
+	gl_Position = vec4(clip.xy * 0.5f * (rect.zw - rect.xy) + clip.w * 0.5f * (rect.xy + rect.zw), clip.zw);
+
+	for (int i = 0; i < 3; i++) {
+		lightPosView[i] = vec3(view * vec4(lightPosition[i], 1.0f));
+	}
+
+	fragPos = vec3(view * model * vec4(position, 1.0f));
+
+	// cameras and scene nodes only rotate, translate and scale uniformly, the inverse transpose is the same matrix up to length
+	vertNormal = normalize(mat3(view * model) * normal);
+}
\ No newline at end of file
@@ -0,0 +1,10 @@
+#version 330 core
+
+layout (location = 0) in vec2 position;
+
+// window size in pixels, position is given in pixels from the top left corner
+uniform vec2 screenSize;
+
+void main() {
+	gl_Position = vec4(2.0f * position.x / screenSize.x - 1.0f, 1.0f - 2.0f * position.y / screenSize.y, 0.0f, 1.0f);
+}
\ No newline at end of file
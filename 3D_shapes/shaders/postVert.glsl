@@ -0,0 +1,15 @@
+#version 330 core
+
+// one triangle covering the target, drawn with glDrawArrays(GL_TRIANGLES, 0, 3) and an empty vertex array
+
+// part of the source texture that holds the rendered image
+uniform vec2 sourceScale;
+
+out vec2 texCoord;
+
+void main() {
+	vec2 corner = vec2((gl_VertexID << 1) & 2, gl_VertexID & 2);
+
+	texCoord	= corner * sourceScale;
+	gl_Position = vec4(2.0f * corner - 1.0f, 0.0f, 1.0f);
+}
\ No newline at end of file
@@ -0,0 +1,151 @@
+#version 330 core
+
+// shapes rebuilt from gl_VertexID without vertex or index buffers, drawn with glDrawArrays(GL_TRIANGLES, 0, 3 * triangles)
+// triangles and corners are numbered like the index buffers the MeshObject generators write
+
+uniform mat4 model;
+uniform mat4 view;
+uniform mat4 projection;
+
+uniform mat3 normal_mat;
+uniform vec3 lightPosition[3];
+
+// 0 disk, 1 uv sphere, 2 torus, 3 trefoil
+uniform int shapeType;
+
+// disk: resolution, sphere: x and y, torus: r and t, trefoil: l and n
+uniform ivec2 divisions;
+
+// disk and sphere: radius, torus: inner and outer, trefoil: n and t
+uniform vec2 radii;
+uniform vec3 shapePosition;
+
+out vec3 fragPos;
+out vec3 vertNormal;
+out vec3 lightPosView[3];
+
+const float TWO_PI = 6.28318531f;
+
+int next(int i, int count) {
+	return (i + 1 == count) ? 0 : i + 1;
+}
+
+// vertex index of a corner on a closed grid of count.x rings with count.y vertices each, two triangles per quad
+int gridIndex(int triangle, int corner, ivec2 count) {
+	int quad = triangle / 2;
+	int i	 = quad / count.y;
+	int j	 = quad % count.y;
+
+	if (corner == 0) return i * count.y + j;
+	if (corner == 1) return (triangle % 2 == 0) ? i * count.y + next(j, count.y) : next(i, count.x) * count.y + j;
+
+	return next(i, count.x) * count.y + next(j, count.y);
+}
+
+void disk(int triangle, int corner, out vec3 position, out vec3 normal) {
+	int resolution = divisions.x;
+	int index = (corner == 0) ? 0 : (corner == 1) ? triangle + 1 : next(triangle, resolution) + 1;
+
+	float theta = TWO_PI * float(index - 1) / float(resolution);
+
+	position = shapePosition + ((index == 0) ? vec3(0.0f) : radii.x * vec3(cos(theta), sin(theta), 0.0f));
+	normal	 = vec3(0.0f, 0.0f, 1.0f);
+}
+
+void sphere(int triangle, int corner, out vec3 position, out vec3 normal) {
+	int countX = divisions.x;
+	int countY = divisions.y;
+	int index;
+
+	int band = triangle - countX;
+	int cap	 = band - 2 * countX * (countY - 1);
+
+	if (band < 0) {
+		// south pole fan
+		index = (corner == 0) ? 0 : 1 + ((corner == 1) ? triangle : next(triangle, countX));
+	}
+	else if (cap < 0) {
+		int i = band / (2 * countX);
+		int j = (band / 2) % countX;
+
+		if (corner == 0) index = 1 + countX * i + j;
+		else if (corner == 1) index = (band % 2 == 0) ? 1 + countX * i + next(j, countX) : 1 + countX * (i + 1) + j;
+		else index = 1 + countX * (i + 1) + next(j, countX);
+	}
+	else {
+		// north pole fan
+		int last = countX * (countY - 1) + 1;
+		index = (corner == 0) ? last + cap : (corner == 1) ? last + next(cap, countX) : last + countX;
+	}
+
+	if (index == 0 || index == countX * countY + 1) {
+		normal = vec3(0.0f, 0.0f, (index == 0) ? -1.0f : 1.0f);
+	}
+	else {
+		float angleY = TWO_PI * 0.5f * float((index - 1) / countX + 1) / float(countY + 1) - TWO_PI * 0.25f;
+		float phi	 = TWO_PI * float((index - 1) % countX) / float(countX);
+
+		normal = vec3(cos(angleY) * cos(phi), cos(angleY) * sin(phi), sin(angleY));
+	}
+
+	position = shapePosition + radii.x * normal;
+}
+
+void torus(int triangle, int corner, out vec3 position, out vec3 normal) {
+	int index = gridIndex(triangle, corner, divisions.yx);
+
+	float phi	= TWO_PI * float(index / divisions.x) / float(divisions.y);
+	float theta = TWO_PI * float(index % divisions.x) / float(divisions.x);
+
+	vec3 ring = vec3(cos(phi), sin(phi), 0.0f);
+
+	normal	 = cos(theta) * ring + vec3(0.0f, 0.0f, sin(theta));
+	position = shapePosition + radii.y * ring + radii.x * normal;
+}
+
+vec3 trefoilCurve(int i) {
+	float theta = TWO_PI * float(i) / float(divisions.x);
+	return radii.y * 0.33f * vec3(sin(theta) + 2.0f * sin(2.0f * theta), cos(theta) - 2.0f * cos(2.0f * theta), -sin(3.0f * theta));
+}
+
+void trefoil(int triangle, int corner, out vec3 position, out vec3 normal) {
+	int index = gridIndex(triangle, corner, divisions);
+	int i = index / divisions.y;
+
+	vec3 point = trefoilCurve(i);
+	vec3 prev  = trefoilCurve((i == 0) ? divisions.x - 1 : i - 1);
+	vec3 after = trefoilCurve(next(i, divisions.x));
+
+	// evenly spaced rings, each turned from +z towards the averaged tangent by its own shortest arc rotation,
+	// unlike the adaptive rings with rotation minimizing frames of the cpu Trefoil
+	vec3 tangent = normalize(normalize(after - point) + normalize(point - prev));
+	float angle	 = acos(clamp(tangent.z, -1.0f, 1.0f));
+	vec4 q		 = normalize(vec4(sin(angle / 2.0f) * cross(vec3(0.0f, 0.0f, 1.0f), tangent), cos(angle / 2.0f)));
+
+	float phi = TWO_PI * float(index % divisions.y) / float(divisions.y);
+	vec3 circle = vec3(cos(phi), sin(phi), 0.0f);
+
+	normal	 = circle + 2.0f * cross(q.xyz, cross(q.xyz, circle) + q.w * circle);
+	position = shapePosition + point + radii.x * normal;
+}
+
+void main() {
+	int triangle = gl_VertexID / 3;
+	int corner	 = gl_VertexID % 3;
+
+	vec3 position, normal;
+
+	if (shapeType == 0) disk(triangle, corner, position, normal);
+	else if (shapeType == 1) sphere(triangle, corner, position, normal);
+	else if (shapeType == 2) torus(triangle, corner, position, normal);
+	else trefoil(triangle, corner, position, normal);
+
+	gl_Position = projection * view * model * vec4(position, 1.0f);
+
+	for (int i = 0; i < 3; i++) {
+		lightPosView[i] = vec3(view * vec4(lightPosition[i], 1.0f));
+	}
+
+	fragPos = vec3(view * model * vec4(position, 1.0f));
+	vertNormal = normalize(normal_mat * normal);
+}
\ No newline at end of file